@@ -2,6 +2,7 @@
 // Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
 
 #include "crunch/base/override.hpp"
+#include "crunch/concurrency/event.hpp"
 #include "crunch/concurrency/meta_scheduler.hpp"
 #include "crunch/concurrency/processor_affinity.hpp"
 #include "crunch/benchmarking/stopwatch.hpp"
@@ -10,8 +11,11 @@
 #include "crunch/benchmarking/stream_result_sink.hpp"
 #include "crunch/test/framework.hpp"
 
+#include <algorithm>
 #include <array>
+#include <memory>
 #include <tuple>
+#include <vector>
 
 namespace Crunch { namespace Concurrency {
 
@@ -76,6 +80,60 @@ BOOST_AUTO_TEST_CASE(SingleThreadedWaitForReadyWaitableBenchmark)
     context.Release();
 }
 
+/// Only the last of a set of events is set, so every call adds and removes a waiter on all the others. Reports time per
+/// call against the number of waitables, i.e., the fan-in cost of waiter allocation, registration and removal.
+BOOST_AUTO_TEST_CASE(WaitForAnyFanInBenchmark)
+{
+    using namespace Benchmarking;
+
+    MetaScheduler::Config configuration;
+    MetaScheduler ms(configuration);
+    MetaScheduler::Context& context = ms.AcquireContext();
+    SetCurrentThreadAffinity(ProcessorAffinity(0));
+    Stopwatch stopwatch;
+
+    ResultTable<std::tuple<std::uint32_t, double, double, double, double, double>> results(
+        "WaitForAnyFanIn",
+        1,
+        std::make_tuple("waitables", "min", "max", "mean", "median", "stddev"));
+
+    StatisticalProfiler profiler(0.01, 100, 1000, 10);
+
+    for (std::uint32_t count = 1; count <= 4096; count *= 4)
+    {
+        std::vector<std::unique_ptr<Event>> events;
+        std::vector<IWaitable*> waitables;
+        for (std::uint32_t i = 0; i < count; ++i)
+        {
+            events.push_back(std::unique_ptr<Event>(new Event()));
+            waitables.push_back(events.back().get());
+        }
+        events.back()->Set();
+
+        int const reps = std::max(1, static_cast<int>(4096 / count));
+
+        profiler.Reset();
+        while (!profiler.IsDone())
+        {
+            stopwatch.Start();
+            for (int i = 0; i < reps; ++i)
+                WaitForAny(&waitables[0], count, WaitMode::Block());
+            stopwatch.Stop();
+            profiler.AddSample(stopwatch.GetElapsedNanoseconds() / reps);
+        }
+
+        results.Add(std::make_tuple(
+            count,
+            profiler.GetMin(),
+            profiler.GetMax(),
+            profiler.GetMean(),
+            profiler.GetMedian(),
+            profiler.GetStdDev()));
+    }
+
+    context.Release();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }}
@@ -0,0 +1,123 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#include "crunch/concurrency/mpmc_fifo_queue.hpp"
+#include "crunch/concurrency/mpmc_lifo_queue.hpp"
+#include "crunch/concurrency/processor_affinity.hpp"
+#include "crunch/concurrency/processor_topology.hpp"
+#include "crunch/concurrency/spin_barrier.hpp"
+#include "crunch/concurrency/thread.hpp"
+
+#include "crunch/benchmarking/stopwatch.hpp"
+#include "crunch/benchmarking/statistical_profiler.hpp"
+#include "crunch/benchmarking/result_table.hpp"
+
+#include "crunch/test/framework.hpp"
+
+namespace Crunch { namespace Concurrency {
+
+BOOST_AUTO_TEST_SUITE(MPMCFifoQueueBenchmarks)
+
+namespace
+{
+    typedef Benchmarking::ResultTable<std::tuple<std::int32_t, char const*, double, double, double, double, double>> ThroughputResultTable;
+
+    /// Every thread is both producer and consumer, so the queue stays short and both ends are contended
+    template<typename QueueType>
+    void RunThroughputBenchmark(ThroughputResultTable& results, char const* queueName)
+    {
+        using namespace Benchmarking;
+
+        std::uint32_t const systemProcCount = GetSystemNumProcessors();
+
+        int const reps = 10000;
+
+        for (std::uint32_t procCount = 1; procCount <= systemProcCount; ++procCount)
+        {
+            QueueType queue;
+            volatile bool done = false;
+            SpinBarrier startBarrier(procCount);
+            SpinBarrier finishBarrier(procCount);
+
+            std::vector<double> threadResults;
+            threadResults.resize(procCount, 0.0);
+
+            auto benchmarkFunc = [&queue, reps] (Stopwatch& stopwatch) -> double
+            {
+                std::uint32_t value = 0;
+                stopwatch.Start();
+                for (int i = 0; i < reps; ++i)
+                {
+                    queue.Push(value);
+                    queue.TryPop(value);
+                }
+                stopwatch.Stop();
+
+                return stopwatch.GetElapsedNanoseconds() / (reps * 2);
+            };
+
+            auto workerFunc = [&] (std::uint32_t index)
+            {
+                SetCurrentThreadAffinity(ProcessorAffinity(index));
+                Benchmarking::Stopwatch stopwatch;
+                for (;;)
+                {
+                    startBarrier.Wait();
+                    if (done)
+                        return;
+                    threadResults[index] = benchmarkFunc(stopwatch);
+                    finishBarrier.Wait();
+                }
+            };
+
+            StatisticalProfiler profiler(0.01, 100, 1000, 10);
+            std::vector<Thread> threads;
+            for (std::uint32_t i = 1; i < procCount; ++i)
+                threads.push_back(Thread([&, i] { workerFunc(i); }));
+
+            Stopwatch stopwatch;
+            while (!profiler.IsDone())
+            {
+                startBarrier.Wait();
+                threadResults[0] = benchmarkFunc(stopwatch);
+                finishBarrier.Wait();
+
+                for (std::uint32_t i = 0; i < procCount; ++i)
+                    profiler.AddSample(threadResults[i]);
+            }
+
+            done = true;
+            startBarrier.Wait();
+            for (std::uint32_t i = 1; i < procCount; ++i)
+                threads[i - 1].Join();
+
+            results.Add(std::make_tuple(
+                procCount,
+                queueName,
+                profiler.GetMin(),
+                profiler.GetMax(),
+                profiler.GetMean(),
+                profiler.GetMedian(),
+                profiler.GetStdDev()));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ThroughputBenchmark)
+{
+    ThroughputResultTable results(
+        "Crunch.Concurrency.MPMCFifoQueue.Throughput",
+        1,
+        std::make_tuple("threads", "queue", "min", "max", "mean", "median", "stddev"));
+
+    ProcessorAffinity const oldAffinity = SetCurrentThreadAffinity(ProcessorAffinity(0));
+
+    RunThroughputBenchmark<MPMCFifoQueue<std::uint32_t>>(results, "fifo_segments");
+    RunThroughputBenchmark<MPMCLifoQueue<std::uint32_t>>(results, "lifo");
+
+    SetCurrentThreadAffinity(oldAffinity);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}}
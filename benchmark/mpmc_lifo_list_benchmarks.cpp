@@ -39,34 +39,116 @@ namespace
 // - Producer/Consumer
 BOOST_AUTO_TEST_SUITE(MPMCLifoListBenchmarks)
 
-BOOST_AUTO_TEST_CASE(PushPopBenchmark)
+namespace
 {
-    using namespace Benchmarking;
+    typedef Benchmarking::ResultTable<std::tuple<std::int32_t, char const*, char const*, double, double, double, double, double>> PushPopResultTable;
 
-    std::uint32_t const systemProcCount = GetSystemNumProcessors();
+    template<typename ListType>
+    void RunPushPopBenchmark(PushPopResultTable& results, char const* rootName)
+    {
+        using namespace Benchmarking;
 
-    int const reps = 10000;
+        std::uint32_t const systemProcCount = GetSystemNumProcessors();
 
-    ResultTable<std::tuple<std::int32_t, char const*, double, double, double, double, double>> results(
-        "Crunch.Concurrency.MPMCLifoList.PushPop",
-        1,
-        std::make_tuple("threads", "operation", "min", "max", "mean", "median", "stddev"));
+        int const reps = 10000;
 
-    ProcessorAffinity const oldAffinity = SetCurrentThreadAffinity(ProcessorAffinity(0));
+        bool push = true;
+        do
+        {
+            ListType list;
+            TestNode node;
+            if (!push)
+            {
+                // Create a cycle for infinite pop
+                list.Push(&node);
+                list.Push(&node);
+            }
+            for (std::uint32_t procCount = 1; procCount <= systemProcCount; ++procCount)
+            {
+                volatile bool done = false;
+                SpinBarrier startBarrier(procCount);
+                SpinBarrier finishBarrier(procCount);
+
+                std::vector<double> threadResults;
+                threadResults.resize(procCount, 0.0);
+
+                auto benchmarkFunc = [&list, reps, push] (Stopwatch& stopwatch) -> double
+                {
+                    stopwatch.Start();
+                    TestNode node;
+                    if (push)
+                        for (int i = 0; i < reps; ++i)
+                            list.Push(&node);
+                    else
+                        for (int i = 0; i < reps; ++i)
+                            list.Pop();
+                    stopwatch.Stop();
+
+                    return stopwatch.GetElapsedNanoseconds() / reps;
+                };
+
+                auto workerFunc = [&] (std::uint32_t index)
+                {
+                    SetCurrentThreadAffinity(ProcessorAffinity(index));
+                    Benchmarking::Stopwatch stopwatch;
+                    for (;;)
+                    {
+                        startBarrier.Wait();
+                        if (done)
+                            return;
+                        threadResults[index] = benchmarkFunc(stopwatch);
+                        finishBarrier.Wait();
+                    }
+                };
+
+                StatisticalProfiler profiler(0.01, 100, 1000, 10);
+                std::vector<Thread> threads;
+                for (std::uint32_t i = 1; i < procCount; ++i)
+                    threads.push_back(Thread([&, i] { workerFunc(i); }));
+
+                Stopwatch stopwatch;
+                while (!profiler.IsDone())
+                {
+                    startBarrier.Wait();
+                    threadResults[0] = benchmarkFunc(stopwatch);
+                    finishBarrier.Wait();
 
-    bool push = true;
-    do
+                    for (std::uint32_t i = 0; i < procCount; ++i)
+                        profiler.AddSample(threadResults[i]);
+                }
+
+                done = true;
+                startBarrier.Wait();
+                for (std::uint32_t i = 1; i < procCount; ++i)
+                    threads[i - 1].Join();
+
+                results.Add(std::make_tuple(
+                    procCount,
+                    rootName,
+                    push ? "push" : "pop",
+                    profiler.GetMin(),
+                    profiler.GetMax(),
+                    profiler.GetMean(),
+                    profiler.GetMedian(),
+                    profiler.GetStdDev()));
+            }
+
+            push = !push;
+        } while (!push);
+    }
+
+    template<typename ListType>
+    void RunMixedBenchmark(PushPopResultTable& results, char const* backoffName)
     {
-        MPMCLifoList<TestNode> list;
-        TestNode node;
-        if (!push)
-        {
-            // Create a cycle for infinite pop
-            list.Push(&node);
-            list.Push(&node);
-        }
+        using namespace Benchmarking;
+
+        std::uint32_t const systemProcCount = GetSystemNumProcessors();
+
+        int const reps = 10000;
+
         for (std::uint32_t procCount = 1; procCount <= systemProcCount; ++procCount)
         {
+            ListType list;
             volatile bool done = false;
             SpinBarrier startBarrier(procCount);
             SpinBarrier finishBarrier(procCount);
@@ -74,19 +156,20 @@ BOOST_AUTO_TEST_CASE(PushPopBenchmark)
             std::vector<double> threadResults;
             threadResults.resize(procCount, 0.0);
 
-            auto benchmarkFunc = [&list, reps, push] (Stopwatch& stopwatch) -> double
+            std::vector<TestNode> nodes(procCount);
+
+            // Each thread alternates push and pop, so about half the operations collide with their opposite
+            auto benchmarkFunc = [&list, reps] (Stopwatch& stopwatch, TestNode* node) -> double
             {
                 stopwatch.Start();
-                TestNode node;
-                if (push)
-                    for (int i = 0; i < reps; ++i)
-                        list.Push(&node);
-                else
-                    for (int i = 0; i < reps; ++i)
-                        list.Pop();
+                for (int i = 0; i < reps; ++i)
+                {
+                    list.Push(node);
+                    while ((node = list.Pop()) == nullptr);
+                }
                 stopwatch.Stop();
 
-                return stopwatch.GetElapsedNanoseconds() / reps;
+                return stopwatch.GetElapsedNanoseconds() / (reps * 2);
             };
 
             auto workerFunc = [&] (std::uint32_t index)
@@ -98,7 +181,7 @@ BOOST_AUTO_TEST_CASE(PushPopBenchmark)
                     startBarrier.Wait();
                     if (done)
                         return;
-                    threadResults[index] = benchmarkFunc(stopwatch);
+                    threadResults[index] = benchmarkFunc(stopwatch, &nodes[index]);
                     finishBarrier.Wait();
                 }
             };
@@ -112,7 +195,7 @@ BOOST_AUTO_TEST_CASE(PushPopBenchmark)
             while (!profiler.IsDone())
             {
                 startBarrier.Wait();
-                threadResults[0] = benchmarkFunc(stopwatch);
+                threadResults[0] = benchmarkFunc(stopwatch, &nodes[0]);
                 finishBarrier.Wait();
 
                 for (std::uint32_t i = 0; i < procCount; ++i)
@@ -126,16 +209,114 @@ BOOST_AUTO_TEST_CASE(PushPopBenchmark)
 
             results.Add(std::make_tuple(
                 procCount,
-                push ? "push" : "pop",
+                backoffName,
+                "push_pop",
+                profiler.GetMin(),
+                profiler.GetMax(),
+                profiler.GetMean(),
+                profiler.GetMedian(),
+                profiler.GetStdDev()));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(PushPopBenchmark)
+{
+    PushPopResultTable results(
+        "Crunch.Concurrency.MPMCLifoList.PushPop",
+        1,
+        std::make_tuple("threads", "root", "operation", "min", "max", "mean", "median", "stddev"));
+
+    ProcessorAffinity const oldAffinity = SetCurrentThreadAffinity(ProcessorAffinity(0));
+
+    RunPushPopBenchmark<MPMCLifoList<TestNode>>(results, "packed");
+    RunPushPopBenchmark<MPMCLifoList<TestNode, ExponentialBackoff, ReclamationPolicyNone, DoubleWidthTaggedPointerPolicy>>(results, "double_width");
+
+    SetCurrentThreadAffinity(oldAffinity);
+}
+
+BOOST_AUTO_TEST_CASE(MixedBenchmark)
+{
+    PushPopResultTable results(
+        "Crunch.Concurrency.MPMCLifoList.Mixed",
+        1,
+        std::make_tuple("threads", "backoff", "operation", "min", "max", "mean", "median", "stddev"));
+
+    ProcessorAffinity const oldAffinity = SetCurrentThreadAffinity(ProcessorAffinity(0));
+
+    RunMixedBenchmark<MPMCLifoList<TestNode, ExponentialBackoff>>(results, "exponential");
+    RunMixedBenchmark<MPMCLifoList<TestNode, EliminationBackoff>>(results, "elimination");
+
+    SetCurrentThreadAffinity(oldAffinity);
+}
+
+BOOST_AUTO_TEST_CASE(BatchBenchmark)
+{
+    using namespace Benchmarking;
+
+    ResultTable<std::tuple<std::int32_t, char const*, double, double, double, double, double>> results(
+        "Crunch.Concurrency.MPMCLifoList.Batch",
+        1,
+        std::make_tuple("batch", "operation", "min", "max", "mean", "median", "stddev"));
+
+    ProcessorAffinity const oldAffinity = SetCurrentThreadAffinity(ProcessorAffinity(0));
+
+    std::uint32_t const maxBatchSize = 1024;
+    std::vector<TestNode> nodes(maxBatchSize);
+    MPMCLifoList<TestNode> list;
+    Stopwatch stopwatch;
+
+    for (std::uint32_t batchSize = 1; batchSize <= maxBatchSize; batchSize *= 2)
+    {
+        // Time is per node moved through the list
+        auto addResult = [&] (char const* operation, StatisticalProfiler const& profiler)
+        {
+            results.Add(std::make_tuple(
+                static_cast<std::int32_t>(batchSize),
+                operation,
                 profiler.GetMin(),
                 profiler.GetMax(),
                 profiler.GetMean(),
                 profiler.GetMedian(),
                 profiler.GetStdDev()));
+        };
+
+        StatisticalProfiler singleProfiler(0.01, 100, 1000, 10);
+        while (!singleProfiler.IsDone())
+        {
+            stopwatch.Start();
+            for (std::uint32_t i = 0; i < batchSize; ++i)
+                list.Push(&nodes[i]);
+            for (std::uint32_t i = 0; i < batchSize; ++i)
+                list.Pop();
+            stopwatch.Stop();
+
+            singleProfiler.AddSample(stopwatch.GetElapsedNanoseconds() / batchSize);
         }
+        addResult("push_pop", singleProfiler);
+
+        StatisticalProfiler batchProfiler(0.01, 100, 1000, 10);
+        while (!batchProfiler.IsDone())
+        {
+            stopwatch.Start();
 
-        push = !push;
-    } while (!push);
+            // Build chain privately, as a producer generating a burst would
+            for (std::uint32_t i = 1; i < batchSize; ++i)
+                nodes[i].next = &nodes[i - 1];
+            list.PushChain(&nodes[batchSize - 1], &nodes[0]);
+
+            // Consume by walking the detached chain
+            std::uint32_t count = 0;
+            for (TestNode* node = list.PopAll(); node != nullptr; node = node->next)
+                count++;
+
+            stopwatch.Stop();
+
+            BOOST_CHECK_EQUAL(count, batchSize);
+            batchProfiler.AddSample(stopwatch.GetElapsedNanoseconds() / batchSize);
+        }
+        addResult("push_chain_pop_all", batchProfiler);
+    }
 
     SetCurrentThreadAffinity(oldAffinity);
 }
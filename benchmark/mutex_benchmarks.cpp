@@ -0,0 +1,126 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#include "crunch/concurrency/mutex.hpp"
+#include "crunch/concurrency/processor_topology.hpp"
+#include "crunch/concurrency/queue_mutex.hpp"
+#include "crunch/concurrency/spin_barrier.hpp"
+#include "crunch/concurrency/thread.hpp"
+
+#include "crunch/benchmarking/stopwatch.hpp"
+#include "crunch/benchmarking/result_table.hpp"
+
+#include "crunch/test/framework.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace Crunch { namespace Concurrency {
+
+BOOST_AUTO_TEST_SUITE(MutexBenchmarks)
+
+namespace
+{
+    typedef Benchmarking::ResultTable<std::tuple<char const*, std::uint32_t, double, double, double, double>> LatencyResultTable;
+
+    double GetPercentile(std::vector<double> const& sorted, double percentile)
+    {
+        std::size_t const index = static_cast<std::size_t>(percentile * (sorted.size() - 1));
+        return sorted[index];
+    }
+
+    /// Every thread repeatedly takes the lock, does a little work while holding it, and a little more outside it.
+    /// Reports the distribution of time from calling Lock to owning the lock, where unfair handoff shows up as a long
+    /// tail of starved waiters.
+    template<typename MutexType>
+    void RunLatencyBenchmark(LatencyResultTable& results, char const* mutexName, MutexType& mutex, std::uint32_t threadCount)
+    {
+        using namespace Benchmarking;
+
+        std::uint32_t const acquisitionCount = 20000;
+
+        SpinBarrier startBarrier(threadCount);
+        volatile std::uint32_t sharedState = 0;
+        std::vector<std::vector<double>> latencies(threadCount);
+
+        std::vector<Thread> threads;
+        for (std::uint32_t t = 0; t < threadCount; ++t)
+        {
+            threads.push_back(Thread([&, t]
+            {
+                std::vector<double>& threadLatencies = latencies[t];
+                threadLatencies.reserve(acquisitionCount);
+
+                Stopwatch stopwatch;
+                volatile std::uint32_t localState = 0;
+
+                startBarrier.Wait();
+                for (std::uint32_t i = 0; i < acquisitionCount; ++i)
+                {
+                    stopwatch.Start();
+                    mutex.Lock();
+                    stopwatch.Stop();
+
+                    for (int j = 0; j < 50; ++j)
+                        sharedState = sharedState + 1;
+
+                    mutex.Unlock();
+                    threadLatencies.push_back(stopwatch.GetElapsedNanoseconds());
+
+                    for (int j = 0; j < 200; ++j)
+                        localState = localState + 1;
+                }
+            }));
+        }
+
+        std::for_each(threads.begin(), threads.end(), [] (Thread& t) { t.Join(); });
+
+        std::vector<double> sorted;
+        sorted.reserve(threadCount * acquisitionCount);
+        std::for_each(latencies.begin(), latencies.end(), [&] (std::vector<double> const& threadLatencies)
+        {
+            sorted.insert(sorted.end(), threadLatencies.begin(), threadLatencies.end());
+        });
+        std::sort(sorted.begin(), sorted.end());
+
+        results.Add(std::make_tuple(
+            mutexName,
+            threadCount,
+            GetPercentile(sorted, 0.5),
+            GetPercentile(sorted, 0.99),
+            GetPercentile(sorted, 0.999),
+            sorted.back()));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(LockLatencyBenchmark)
+{
+    LatencyResultTable results(
+        "Crunch.Concurrency.Mutex.LockLatency",
+        1,
+        std::make_tuple("mutex", "threads", "p50", "p99", "p999", "max"));
+
+    // Oversubscribe to also cover waiters that have gone to sleep
+    std::uint32_t const systemProcCount = GetSystemNumProcessors();
+    std::uint32_t const threadCounts[] = { 2, systemProcCount, systemProcCount * 2 };
+    std::uint32_t const spinCount = 100;
+
+    std::for_each(threadCounts, threadCounts + 3, [&] (std::uint32_t threadCount)
+    {
+        Mutex unfair(spinCount, Mutex::MODE_UNFAIR);
+        RunLatencyBenchmark(results, "unfair", unfair, threadCount);
+
+        Mutex adaptive(Mutex::ADAPTIVE_SPIN, Mutex::MODE_UNFAIR);
+        RunLatencyBenchmark(results, "unfair adaptive", adaptive, threadCount);
+
+        Mutex fair(spinCount, Mutex::MODE_FAIR);
+        RunLatencyBenchmark(results, "fair", fair, threadCount);
+
+        QueueMutex queue(spinCount);
+        RunLatencyBenchmark(results, "queue", queue, threadCount);
+    });
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}}
@@ -0,0 +1,136 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#include "crunch/base/assert.hpp"
+#include "crunch/concurrency/detail/system_semaphore.hpp"
+#include "crunch/concurrency/processor_affinity.hpp"
+#include "crunch/concurrency/processor_topology.hpp"
+#include "crunch/concurrency/thread.hpp"
+
+#include "crunch/benchmarking/stopwatch.hpp"
+#include "crunch/benchmarking/statistical_profiler.hpp"
+#include "crunch/benchmarking/result_table.hpp"
+
+#include "crunch/test/framework.hpp"
+
+#if defined (CRUNCH_PLATFORM_LINUX)
+#   include <semaphore.h>
+#endif
+
+namespace Crunch { namespace Concurrency {
+
+BOOST_AUTO_TEST_SUITE(SystemSemaphoreBenchmarks)
+
+namespace
+{
+#if defined (CRUNCH_PLATFORM_LINUX)
+    /// Baseline on top of the POSIX semaphore the futex implementation replaced
+    class PosixSemaphore
+    {
+    public:
+        PosixSemaphore(std::uint32_t initialCount)
+        {
+            CRUNCH_ASSERT_ALWAYS(sem_init(&mSemaphore, 0, initialCount) == 0);
+        }
+
+        ~PosixSemaphore()
+        {
+            sem_destroy(&mSemaphore);
+        }
+
+        void Post()
+        {
+            CRUNCH_ASSERT_ALWAYS(sem_post(&mSemaphore) == 0);
+        }
+
+        void Wait()
+        {
+            CRUNCH_ASSERT_ALWAYS(sem_wait(&mSemaphore) == 0);
+        }
+
+    private:
+        sem_t mSemaphore;
+    };
+#endif
+
+    typedef Benchmarking::ResultTable<std::tuple<char const*, char const*, double, double, double, double, double>> PingPongResultTable;
+
+    /// Two threads hand a token back and forth through a pair of semaphores. Reports time per hand-off, i.e., the
+    /// latency from Post to the blocked thread returning from Wait.
+    template<typename SemaphoreType>
+    void RunPingPongBenchmark(PingPongResultTable& results, char const* semaphoreName, char const* placement, std::uint32_t otherProcessor)
+    {
+        using namespace Benchmarking;
+
+        int const reps = 1000;
+
+        SemaphoreType ping(0);
+        SemaphoreType pong(0);
+        volatile bool done = false;
+
+        Thread thread([&]
+        {
+            SetCurrentThreadAffinity(ProcessorAffinity(otherProcessor));
+            for (;;)
+            {
+                ping.Wait();
+                if (done)
+                    return;
+                pong.Post();
+            }
+        });
+
+        StatisticalProfiler profiler(0.01, 100, 1000, 10);
+        Stopwatch stopwatch;
+        while (!profiler.IsDone())
+        {
+            stopwatch.Start();
+            for (int i = 0; i < reps; ++i)
+            {
+                ping.Post();
+                pong.Wait();
+            }
+            stopwatch.Stop();
+            profiler.AddSample(stopwatch.GetElapsedNanoseconds() / (reps * 2));
+        }
+
+        done = true;
+        ping.Post();
+        thread.Join();
+
+        results.Add(std::make_tuple(
+            semaphoreName,
+            placement,
+            profiler.GetMin(),
+            profiler.GetMax(),
+            profiler.GetMean(),
+            profiler.GetMedian(),
+            profiler.GetStdDev()));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(PingPongBenchmark)
+{
+    PingPongResultTable results(
+        "Crunch.Concurrency.SystemSemaphore.PingPong",
+        1,
+        std::make_tuple("semaphore", "placement", "min", "max", "mean", "median", "stddev"));
+
+    ProcessorAffinity const oldAffinity = SetCurrentThreadAffinity(ProcessorAffinity(0));
+
+    // Same processor measures the cost of the wake and context switch, different processors the cross-core wakeup
+    std::uint32_t const otherProcessor = GetSystemNumProcessors() > 1 ? 1 : 0;
+
+    RunPingPongBenchmark<Detail::SystemSemaphore>(results, "system", "same", 0);
+    RunPingPongBenchmark<Detail::SystemSemaphore>(results, "system", "cross", otherProcessor);
+#if defined (CRUNCH_PLATFORM_LINUX)
+    RunPingPongBenchmark<PosixSemaphore>(results, "posix", "same", 0);
+    RunPingPongBenchmark<PosixSemaphore>(results, "posix", "cross", otherProcessor);
+#endif
+
+    SetCurrentThreadAffinity(oldAffinity);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}}
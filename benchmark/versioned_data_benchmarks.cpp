@@ -0,0 +1,142 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#include "crunch/concurrency/processor_affinity.hpp"
+#include "crunch/concurrency/processor_topology.hpp"
+#include "crunch/concurrency/spin_barrier.hpp"
+#include "crunch/concurrency/thread.hpp"
+#include "crunch/concurrency/versioned_data.hpp"
+#include "crunch/concurrency/yield.hpp"
+
+#include "crunch/benchmarking/stopwatch.hpp"
+#include "crunch/benchmarking/statistical_profiler.hpp"
+#include "crunch/benchmarking/result_table.hpp"
+
+#include "crunch/test/framework.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace Crunch { namespace Concurrency {
+
+BOOST_AUTO_TEST_SUITE(VersionedDataBenchmarks)
+
+namespace
+{
+    struct Config
+    {
+        std::uint32_t values[16];
+    };
+
+    typedef Benchmarking::ResultTable<std::tuple<char const*, std::uint32_t, double, double, double, double, double>> ReadResultTable;
+
+    /// Readers on their own processors each read the data as fast as they can, while a writer updates it every few
+    /// microseconds. Reports time per read, which should stay flat with reader count if reads don't contend.
+    template<typename DataType>
+    void RunReaderScalingBenchmark(ReadResultTable& results, char const* dataName)
+    {
+        using namespace Benchmarking;
+
+        std::uint32_t const systemProcCount = GetSystemNumProcessors();
+        int const reps = 10000;
+
+        for (std::uint32_t readerCount = 1; readerCount <= systemProcCount; readerCount *= 2)
+        {
+            DataType data;
+            volatile bool done = false;
+            SpinBarrier startBarrier(readerCount);
+            SpinBarrier finishBarrier(readerCount);
+            std::vector<double> threadResults(readerCount, 0.0);
+
+            auto benchmarkFunc = [&] (Stopwatch& stopwatch) -> double
+            {
+                volatile std::uint32_t sink = 0;
+                stopwatch.Start();
+                for (int i = 0; i < reps; ++i)
+                {
+                    // Force a read every time
+                    std::uint32_t version = 0xfffffffful;
+                    data.ReadIfDifferent(version, [&] (Config const& config) { sink = config.values[0]; });
+                }
+                stopwatch.Stop();
+                return stopwatch.GetElapsedNanoseconds() / reps;
+            };
+
+            auto readerFunc = [&] (std::uint32_t index)
+            {
+                SetCurrentThreadAffinity(ProcessorAffinity(index));
+                Stopwatch stopwatch;
+                for (;;)
+                {
+                    startBarrier.Wait();
+                    if (done)
+                        return;
+                    threadResults[index] = benchmarkFunc(stopwatch);
+                    finishBarrier.Wait();
+                }
+            };
+
+            volatile bool writerDone = false;
+            Thread writer([&]
+            {
+                std::uint32_t value = 0;
+                while (!writerDone)
+                {
+                    ++value;
+                    data.Update([value] (Config& config) { std::fill(config.values, config.values + 16, value); });
+                    for (int i = 0; i < 1000; ++i)
+                        CRUNCH_PAUSE();
+                }
+            });
+
+            std::vector<Thread> readers;
+            for (std::uint32_t i = 1; i < readerCount; ++i)
+                readers.push_back(Thread([&, i] { readerFunc(i); }));
+
+            ProcessorAffinity const oldAffinity = SetCurrentThreadAffinity(ProcessorAffinity(0));
+            StatisticalProfiler profiler(0.01, 100, 1000, 10);
+            Stopwatch stopwatch;
+            while (!profiler.IsDone())
+            {
+                startBarrier.Wait();
+                threadResults[0] = benchmarkFunc(stopwatch);
+                finishBarrier.Wait();
+
+                for (std::uint32_t i = 0; i < readerCount; ++i)
+                    profiler.AddSample(threadResults[i]);
+            }
+
+            done = true;
+            startBarrier.Wait();
+            std::for_each(readers.begin(), readers.end(), [] (Thread& t) { t.Join(); });
+            SetCurrentThreadAffinity(oldAffinity);
+
+            writerDone = true;
+            writer.Join();
+
+            results.Add(std::make_tuple(
+                dataName,
+                readerCount,
+                profiler.GetMin(),
+                profiler.GetMax(),
+                profiler.GetMean(),
+                profiler.GetMedian(),
+                profiler.GetStdDev()));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ReaderScalingBenchmark)
+{
+    ReadResultTable results(
+        "Crunch.Concurrency.VersionedData.ReaderScaling",
+        1,
+        std::make_tuple("data", "readers", "min", "max", "mean", "median", "stddev"));
+
+    RunReaderScalingBenchmark<VersionedData<Config>>(results, "mutex");
+    RunReaderScalingBenchmark<SeqLockVersionedData<Config>>(results, "seqlock");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}}
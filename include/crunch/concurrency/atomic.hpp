@@ -12,6 +12,8 @@
 #   include "crunch/concurrency/platform/linux/atomic.hpp"
 #endif
 
+#include "crunch/concurrency/detail/atomic_wait.hpp"
+
 #include <type_traits>
 
 namespace Crunch { namespace Concurrency {
@@ -69,6 +71,26 @@ public:
         return Platform::AtomicCompareAndSwap(mData.bits, cmp, src_.bits, ordering);
     }
 
+    /// Block until the value differs from old. Changes must be followed by NotifyOne or NotifyAll to wake waiters.
+    void Wait(ValueType old, MemoryOrder ordering = MEMORY_ORDER_SEQ_CST) const volatile
+    {
+        Converter old_;
+        old_.value = old;
+
+        while (Detail::AtomicWordEqual<WordType>(Platform::AtomicLoad(mData.bits, ordering), old_.bits))
+            Detail::AtomicWaitTraits<WordType>::Wait(mData.bits, old_.bits);
+    }
+
+    void NotifyOne() volatile
+    {
+        Detail::AtomicWaitTraits<WordType>::Notify(mData.bits, false);
+    }
+
+    void NotifyAll() volatile
+    {
+        Detail::AtomicWaitTraits<WordType>::Notify(mData.bits, true);
+    }
+
     operator ValueType () const volatile
     {
         return Load();
@@ -120,6 +142,23 @@ public:
         return Platform::AtomicCompareAndSwap(mData.bits, cmp, src, ordering);
     }
 
+    /// Block until the value differs from old. Changes must be followed by NotifyOne or NotifyAll to wake waiters.
+    void Wait(ValueType old, MemoryOrder ordering = MEMORY_ORDER_SEQ_CST) const volatile
+    {
+        while (Platform::AtomicLoad(mData.bits, ordering) == old)
+            Detail::AtomicWaitTraits<WordType>::Wait(mData.bits, old);
+    }
+
+    void NotifyOne() volatile
+    {
+        Detail::AtomicWaitTraits<WordType>::Notify(mData.bits, false);
+    }
+
+    void NotifyAll() volatile
+    {
+        Detail::AtomicWaitTraits<WordType>::Notify(mData.bits, true);
+    }
+
     operator ValueType () const volatile
     {
         return Load();
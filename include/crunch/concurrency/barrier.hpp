@@ -0,0 +1,62 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#ifndef CRUNCH_CONCURRENCY_BARRIER_HPP
+#define CRUNCH_CONCURRENCY_BARRIER_HPP
+
+#include "crunch/base/noncopyable.hpp"
+#include "crunch/base/override.hpp"
+#include "crunch/concurrency/api.hpp"
+#include "crunch/concurrency/atomic.hpp"
+#include "crunch/concurrency/detail/cache_line.hpp"
+#include "crunch/concurrency/detail/waiter_list.hpp"
+
+#include <cstdint>
+
+namespace Crunch { namespace Concurrency {
+
+/// Reusable barrier for a fixed number of participants that spins for a while and then sleeps.
+/// Participants that arrive through AddWaiter, e.g., with WaitFor or WaitForAll, are notified when the phase completes
+/// instead of blocking, so a barrier can be waited on together with other waitables.
+class Barrier : public IWaitable, NonCopyable
+{
+public:
+    using IWaitable::AddWaiter;
+
+    /// \param count Number of participants
+    /// \param spinCount Number of times Wait checks for phase completion before going to sleep
+    CRUNCH_CONCURRENCY_API Barrier(std::uint32_t count, std::uint32_t spinCount = 1000);
+
+    /// Arrive and wait for the remaining participants
+    /// \return true for the one participant that completed the phase
+    CRUNCH_CONCURRENCY_API bool Wait();
+
+    /// Arrive. Waiter is notified once the remaining participants have arrived.
+    /// \return false if this arrival completed the phase
+    CRUNCH_CONCURRENCY_API CRUNCH_MUST_CHECK_RESULT virtual bool AddWaiter(Waiter* waiter) CRUNCH_OVERRIDE;
+
+    /// Withdraw arrival, unless the phase is already completing
+    CRUNCH_CONCURRENCY_API CRUNCH_MUST_CHECK_RESULT virtual bool RemoveWaiter(Waiter* waiter) CRUNCH_OVERRIDE;
+
+    // Constant
+    CRUNCH_CONCURRENCY_API virtual bool IsOrderDependent() const CRUNCH_OVERRIDE;
+
+private:
+    /// Reset for the next phase and wake everyone in this one. Waiter is the completing participant's own, if any,
+    /// which isn't notified.
+    void Complete(std::uint32_t phase, Waiter* waiter);
+
+    std::uint32_t const mCount;
+    std::uint32_t const mSpinCount;
+
+    // Written once per phase and read by every waiting participant
+    Detail::CacheLineAligned<Atomic<std::uint32_t>> mPhase;
+
+    // Written by every arrival
+    Detail::CacheLineAligned<Atomic<std::uint32_t>> mRemaining;
+    Detail::WaiterList mWaiters;
+};
+
+}}
+
+#endif
@@ -0,0 +1,81 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#ifndef CRUNCH_CONCURRENCY_DETAIL_ATOMIC_WAIT_HPP
+#define CRUNCH_CONCURRENCY_DETAIL_ATOMIC_WAIT_HPP
+
+#include "crunch/base/platform.hpp"
+#include "crunch/concurrency/api.hpp"
+#include "crunch/concurrency/memory_order.hpp"
+
+#if defined (CRUNCH_PLATFORM_WIN32)
+#   include "crunch/concurrency/platform/win32/atomic.hpp"
+#elif defined (CRUNCH_PLATFORM_LINUX) || defined (CRUNCH_PLATFORM_DARWIN)
+#   include "crunch/concurrency/platform/linux/atomic.hpp"
+#endif
+
+#include <cstdint>
+#include <cstring>
+
+namespace Crunch { namespace Concurrency { namespace Detail {
+
+/// Atomic words are compared bitwise, which also works for 16 byte vector words
+template<typename W>
+bool AtomicWordEqual(W const& lhs, W const& rhs)
+{
+    return std::memcmp(&lhs, &rhs, sizeof(W)) == 0;
+}
+
+typedef bool (*AtomicWaitPredicate)(void const volatile* address, void const* expected);
+
+/// Sleep while predicate holds, on a condition in a table of buckets hashed by address.
+/// Notify wakes every waiter in the bucket, so waiters sharing it with other addresses see spurious wakeups.
+CRUNCH_CONCURRENCY_API void AtomicParkedWait(void const volatile* address, AtomicWaitPredicate isUnchanged, void const* expected);
+CRUNCH_CONCURRENCY_API void AtomicParkedNotify(void const volatile* address);
+
+#if defined (CRUNCH_PLATFORM_LINUX)
+/// Sleep on a futex on the word itself. Notify skips the syscall unless a waiter is registered in the word's bucket.
+CRUNCH_CONCURRENCY_API void AtomicFutexWait(std::int32_t const volatile* address, std::int32_t expected);
+CRUNCH_CONCURRENCY_API void AtomicFutexNotify(std::int32_t const volatile* address, bool all);
+#endif
+
+/// Sleep at most once while word equals expected. May return spuriously.
+template<typename W>
+struct AtomicWaitTraits
+{
+    static void Wait(W const volatile& word, W const& expected)
+    {
+        AtomicParkedWait(&word, &IsUnchanged, &expected);
+    }
+
+    static void Notify(W const volatile& word, bool)
+    {
+        AtomicParkedNotify(&word);
+    }
+
+    static bool IsUnchanged(void const volatile* address, void const* expected)
+    {
+        W const current = Platform::AtomicLoad(*static_cast<W const volatile*>(address), MEMORY_ORDER_RELAXED);
+        return AtomicWordEqual(current, *static_cast<W const*>(expected));
+    }
+};
+
+#if defined (CRUNCH_PLATFORM_LINUX)
+template<>
+struct AtomicWaitTraits<std::int32_t>
+{
+    static void Wait(std::int32_t const volatile& word, std::int32_t expected)
+    {
+        AtomicFutexWait(&word, expected);
+    }
+
+    static void Notify(std::int32_t const volatile& word, bool all)
+    {
+        AtomicFutexNotify(&word, all);
+    }
+};
+#endif
+
+}}}
+
+#endif
@@ -0,0 +1,51 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#ifndef CRUNCH_CONCURRENCY_DETAIL_CACHE_LINE_HPP
+#define CRUNCH_CONCURRENCY_DETAIL_CACHE_LINE_HPP
+
+#include "crunch/base/align.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+// Must be a literal for use with CRUNCH_ALIGN_PREFIX
+#define CRUNCH_CACHE_LINE_SIZE 64
+
+namespace Crunch { namespace Concurrency { namespace Detail {
+
+/// Value on its own cache line to avoid false sharing with neighbouring data
+template<typename T>
+struct CRUNCH_ALIGN_PREFIX(CRUNCH_CACHE_LINE_SIZE) CacheLineAligned
+{
+    T value;
+} CRUNCH_ALIGN_POSTFIX(CRUNCH_CACHE_LINE_SIZE);
+
+/// Allocate size bytes starting on a cache line boundary. Pre C++17 operator new doesn't honour extended alignment,
+/// so heap allocated types containing CacheLineAligned members must be placed in storage from here.
+inline void* AllocateCacheLineAligned(std::size_t size)
+{
+    // Room to align, with the original pointer stored just below the aligned block
+    void* const allocation = std::malloc(size + CRUNCH_CACHE_LINE_SIZE);
+    if (allocation == nullptr)
+        throw std::bad_alloc();
+
+    std::uintptr_t const aligned =
+        (reinterpret_cast<std::uintptr_t>(allocation) + CRUNCH_CACHE_LINE_SIZE) &
+        ~std::uintptr_t(CRUNCH_CACHE_LINE_SIZE - 1);
+
+    reinterpret_cast<void**>(aligned)[-1] = allocation;
+    return reinterpret_cast<void*>(aligned);
+}
+
+inline void FreeCacheLineAligned(void* allocation)
+{
+    if (allocation != nullptr)
+        std::free(static_cast<void**>(allocation)[-1]);
+}
+
+}}}
+
+#endif
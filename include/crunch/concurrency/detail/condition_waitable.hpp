@@ -0,0 +1,60 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#ifndef CRUNCH_CONCURRENCY_DETAIL_CONDITION_WAITABLE_HPP
+#define CRUNCH_CONCURRENCY_DETAIL_CONDITION_WAITABLE_HPP
+
+#include "crunch/base/noncopyable.hpp"
+#include "crunch/base/override.hpp"
+#include "crunch/concurrency/api.hpp"
+#include "crunch/concurrency/fence.hpp"
+#include "crunch/concurrency/detail/waiter_list.hpp"
+
+namespace Crunch { namespace Concurrency { namespace Detail {
+
+/// Waitable for a condition whose state lives elsewhere, e.g., a queue being non-empty.
+/// Waiters publish themselves before re-checking the condition, and the signaling side must call Notify after making
+/// the condition true. Either the waiter sees the condition or Notify sees the waiter. Notify only costs a fence and
+/// a load when there are no waiters.
+class ConditionWaitable : public IWaitable, NonCopyable
+{
+public:
+    typedef bool (*IsReadyFunction)(void const* context);
+
+    using IWaitable::AddWaiter;
+
+    ConditionWaitable(IsReadyFunction isReady, void const* context)
+        : mIsReady(isReady)
+        , mContext(context)
+        , mWaiters(0)
+    {}
+
+    void Notify()
+    {
+        // Pairs with fence in AddWaiter
+        CRUNCH_MEMORY_FENCE();
+
+        if ((mWaiters.Load(MEMORY_ORDER_RELAXED) & WaiterList::PTR_MASK) != 0)
+            NotifyAll();
+    }
+
+    // Lock free
+    CRUNCH_CONCURRENCY_API CRUNCH_MUST_CHECK_RESULT virtual bool AddWaiter(Waiter* waiter) CRUNCH_OVERRIDE;
+
+    // Locked with RemoveWaiter and Notify
+    CRUNCH_CONCURRENCY_API CRUNCH_MUST_CHECK_RESULT virtual bool RemoveWaiter(Waiter* waiter) CRUNCH_OVERRIDE;
+
+    // Constant
+    CRUNCH_CONCURRENCY_API virtual bool IsOrderDependent() const CRUNCH_OVERRIDE;
+
+private:
+    CRUNCH_CONCURRENCY_API void NotifyAll();
+
+    IsReadyFunction const mIsReady;
+    void const* const mContext;
+    WaiterList mWaiters;
+};
+
+}}}
+
+#endif
@@ -139,7 +139,7 @@ private:
         return *static_cast<T*>(ResultAddress());
     }
 
-    typedef std::aligned_storage<sizeof(T), std::alignment_of<T>::value> StorageType;
+    typedef typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type StorageType;
 
     void* ResultAddress() { return static_cast<void*>(&mResult); }
 
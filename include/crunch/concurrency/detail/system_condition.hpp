@@ -9,7 +9,10 @@
 
 #if defined (CRUNCH_PLATFORM_WIN32)
 #   include <type_traits>
-#elif defined (CRUNCH_PLATFORM_LINUX) || defined (CRUNCH_PLATFORM_DARWIN)
+#elif defined (CRUNCH_PLATFORM_LINUX)
+#   include "crunch/concurrency/atomic.hpp"
+#   include <cstdint>
+#elif defined (CRUNCH_PLATFORM_DARWIN)
 #   include <pthread.h>
 #else
 #   error "Unsupported platform"
@@ -31,6 +34,11 @@ private:
 #if defined (CRUNCH_PLATFORM_WIN32)
     typedef std::aligned_storage<8, 8>::type ConditionVariableStorageType;
     ConditionVariableStorageType mConditionVariableStorage;
+#elif defined (CRUNCH_PLATFORM_LINUX)
+    // Futex word, bumped by every wake so a waiter that released the mutex can't miss one
+    Atomic<std::uint32_t> mSequence;
+    // Mutex of the last waiter. Target for requeueing waiters on WakeAll.
+    Atomic<SystemMutex*> mMutex;
 #else
     pthread_cond_t mCondition;
 #endif
@@ -9,7 +9,10 @@
 
 #if defined (CRUNCH_PLATFORM_WIN32)
 #   include "crunch/base/platform/win32/wintypes.hpp"
-#elif defined (CRUNCH_PLATFORM_LINUX) || defined (CRUNCH_PLATFORM_DARWIN)
+#elif defined (CRUNCH_PLATFORM_LINUX)
+#   include "crunch/concurrency/atomic.hpp"
+#   include <cstdint>
+#elif defined (CRUNCH_PLATFORM_DARWIN)
 #   include <pthread.h>
 #else
 #   error "Unsupported platform"
@@ -30,8 +33,10 @@ public:
 private:
 #if defined (CRUNCH_PLATFORM_WIN32)
     HANDLE mEvent;
+#elif defined (CRUNCH_PLATFORM_LINUX)
+    // Futex word. 0 unset, 1 set, 2 unset with sleepers.
+    Atomic<std::uint32_t> mState;
 #else
-    // TODO: more efficient implementation with futexes
     pthread_mutex_t mMutex;
     pthread_cond_t mCondition;
     volatile bool mState;
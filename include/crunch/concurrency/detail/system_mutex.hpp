@@ -10,7 +10,10 @@
 
 #if defined (CRUNCH_PLATFORM_WIN32)
 #   include <type_traits>
-#elif defined (CRUNCH_PLATFORM_LINUX) || defined (CRUNCH_PLATFORM_DARWIN)
+#elif defined (CRUNCH_PLATFORM_LINUX)
+#   include "crunch/concurrency/atomic.hpp"
+#   include <cstdint>
+#elif defined (CRUNCH_PLATFORM_DARWIN)
 #   include <pthread.h>
 #else
 #   error "Unsupported platform"
@@ -39,6 +42,16 @@ private:
 #if defined (CRUNCH_PLATFORM_WIN32)
     typedef std::aligned_storage<40, 8>::type CriticalSectionStorageType;
     CriticalSectionStorageType mCriticalSectionStorage;
+#elif defined (CRUNCH_PLATFORM_LINUX)
+    static std::uint32_t const UNLOCKED = 0;
+    static std::uint32_t const LOCKED = 1;
+    static std::uint32_t const CONTENDED = 2;
+
+    // Acquire, leaving the lock marked as contended
+    void LockContended(std::uint32_t state);
+
+    // Futex word
+    Atomic<std::uint32_t> mState;
 #else
     pthread_mutex_t mMutex;
 #endif
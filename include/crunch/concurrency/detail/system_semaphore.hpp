@@ -4,6 +4,7 @@
 #ifndef CRUNCH_CONCURRENCY_DETAIL_SYSTEM_SEMAPHORE_HPP
 #define CRUNCH_CONCURRENCY_DETAIL_SYSTEM_SEMAPHORE_HPP
 
+#include "crunch/base/duration.hpp"
 #include "crunch/base/platform.hpp"
 #include "crunch/concurrency/yield.hpp"
 
@@ -11,7 +12,7 @@
 #   include "crunch/base/platform/win32/wintypes.hpp"
 #   include "crunch/concurrency/atomic.hpp"
 #elif defined (CRUNCH_PLATFORM_LINUX)
-#   include <semaphore.h>
+#   include "crunch/concurrency/atomic.hpp"
 #elif defined (CRUNCH_PLATFORM_DARWIN)
 #   include "crunch/concurrency/atomic.hpp"
 #   include <mach/semaphore.h>
@@ -34,13 +35,33 @@ public:
     bool TryWait();
     void SpinWait(std::uint32_t spinCount);
 
+    /// \return false if timeout elapsed before the semaphore could be acquired
+    bool Wait(Duration timeout);
+    bool SpinWait(std::uint32_t spinCount, Duration timeout);
+
 private:
 #if defined (CRUNCH_PLATFORM_WIN32)
+    // Undo the count of a timed out Wait
+    // \return true if a Post got there first, in which case the semaphore has been acquired after all
+    bool Withdraw();
+
     Atomic<std::int32_t> mCount;
     HANDLE mSemaphore;
 #elif defined (CRUNCH_PLATFORM_LINUX)
-    sem_t mSemaphore;
+    // Acquire a count, or else flag the futex word as having sleepers
+    // \return false if the caller should sleep on the flagged word
+    bool TryWaitOrSleep();
+    void RemoveSleeper();
+
+    // Futex word holding the count and a has-sleepers flag. Post only enters the kernel while the flag is set.
+    Atomic<std::uint32_t> mValue;
+    // Only touched by waiters, which keep the semaphore alive
+    Atomic<std::uint32_t> mSleeperCount;
 #elif defined (CRUNCH_PLATFORM_DARWIN)
+    // Undo the count of a timed out Wait
+    // \return true if a Post got there first, in which case the semaphore has been acquired after all
+    bool Withdraw();
+
     Atomic<std::int32_t> mCount;
     semaphore_t mSemaphore;
 #endif
@@ -59,6 +80,25 @@ inline void SystemSemaphore::SpinWait(std::uint32_t spinCount)
     Wait();
 }
 
+inline bool SystemSemaphore::SpinWait(std::uint32_t spinCount, Duration timeout)
+{
+    if (timeout.IsPosInfinity())
+    {
+        SpinWait(spinCount);
+        return true;
+    }
+
+    while (spinCount--)
+    {
+        if (TryWait())
+            return true;
+
+        CRUNCH_PAUSE();
+    }
+
+    return Wait(timeout);
+}
+
 }}}
 
 #endif
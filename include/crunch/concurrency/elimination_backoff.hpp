@@ -0,0 +1,189 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#ifndef CRUNCH_CONCURRENCY_ELIMINATION_BACKOFF_HPP
+#define CRUNCH_CONCURRENCY_ELIMINATION_BACKOFF_HPP
+
+#include "crunch/base/assert.hpp"
+#include "crunch/base/noncopyable.hpp"
+#include "crunch/concurrency/atomic.hpp"
+#include "crunch/concurrency/yield.hpp"
+#include "crunch/concurrency/detail/cache_line.hpp"
+
+#include <cstdint>
+
+namespace Crunch { namespace Concurrency {
+
+/// Backoff policy for LIFO containers where a Push and a Pop that both fail their CAS on the root may cancel each
+/// other out through a side array, instead of retrying against the contended root. The first retry uses one slot,
+/// and the range doubles with every further collision up to Width. Offers are withdrawn after SpinCount pauses.
+/// Nodes must be at least 2 byte aligned.
+///
+/// Reference: Hendler, Shavit, Yerushalmi. A Scalable Lock-free Stack Algorithm. SPAA 2004.
+template<std::uint32_t Width, std::uint32_t SpinCount>
+class EliminationBackoffT
+{
+public:
+    EliminationBackoffT()
+        : mRange(1)
+        , mRandomState(static_cast<std::uint32_t>(reinterpret_cast<std::uintptr_t>(this) >> 4) | 1)
+    {}
+
+    /// Waiting for a partner in the elimination array is the backoff, so just relax the pipeline
+    void Pause()
+    {
+        CRUNCH_PAUSE();
+    }
+
+    bool TryPause()
+    {
+        CRUNCH_PAUSE();
+        return true;
+    }
+
+    void Reset()
+    {
+        mRange = 1;
+    }
+
+    /// Pick slot for the next elimination attempt and widen the range for the one after
+    std::uint32_t NextSlot()
+    {
+        // xorshift32
+        std::uint32_t x = mRandomState;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        mRandomState = x;
+
+        std::uint32_t const slot = x % mRange;
+        if (mRange < Width)
+            mRange *= 2;
+
+        return slot;
+    }
+
+    static std::uint32_t const WIDTH = Width;
+    static std::uint32_t const SPIN_COUNT = SpinCount;
+
+private:
+    std::uint32_t mRange;
+    std::uint32_t mRandomState;
+};
+
+typedef EliminationBackoffT<8, 128> EliminationBackoff;
+
+namespace Detail
+{
+    /// Shared state a backoff policy needs per container. Ordinary backoff policies never eliminate.
+    template<typename BackoffPolicy, typename T>
+    struct EliminationArray
+    {
+        bool TryEliminatePush(BackoffPolicy&, T*)
+        {
+            return false;
+        }
+
+        T* TryEliminatePop(BackoffPolicy&)
+        {
+            return nullptr;
+        }
+    };
+
+    /// Each slot is empty, holds a node offered by a Push, a Pop waiting for a node, or a node delivered to a
+    /// waiting Pop. Poppers only take offered nodes, and pushers only deliver to waiting poppers, so a delivered node
+    /// can't be stolen by a third thread.
+    template<std::uint32_t Width, std::uint32_t SpinCount, typename T>
+    struct EliminationArray<EliminationBackoffT<Width, SpinCount>, T> : NonCopyable
+    {
+        typedef EliminationBackoffT<Width, SpinCount> BackoffType;
+
+        static std::uintptr_t const EMPTY = 0;
+        static std::uintptr_t const WAITING_POP = 1;
+        static std::uintptr_t const DELIVERED_BIT = 1;
+
+        EliminationArray()
+        {
+            for (std::uint32_t i = 0; i < Width; ++i)
+                mSlots[i].value.Store(EMPTY, MEMORY_ORDER_RELAXED);
+        }
+
+        bool TryEliminatePush(BackoffType& backoff, T* node)
+        {
+            std::uintptr_t const offer = reinterpret_cast<std::uintptr_t>(node);
+            CRUNCH_ASSERT_MSG((offer & DELIVERED_BIT) == 0, "Elimination requires 2 byte aligned nodes");
+
+            Atomic<std::uintptr_t>& slot = mSlots[backoff.NextSlot()].value;
+            std::uintptr_t state = slot.Load(MEMORY_ORDER_RELAXED);
+
+            // Hand node straight to a waiting Pop
+            if (state == WAITING_POP)
+                return slot.CompareAndSwap(state, offer | DELIVERED_BIT, MEMORY_ORDER_RELEASE);
+
+            if (state != EMPTY || !slot.CompareAndSwap(state, offer, MEMORY_ORDER_RELEASE))
+                return false;
+
+            // Wait for a Pop to take the offer
+            for (std::uint32_t i = 0; i < SpinCount; ++i)
+            {
+                if (slot.Load(MEMORY_ORDER_RELAXED) != offer)
+                    return true;
+
+                CRUNCH_PAUSE();
+            }
+
+            // Withdraw. Failure means a Pop took the node.
+            std::uintptr_t expected = offer;
+            return !slot.CompareAndSwap(expected, EMPTY, MEMORY_ORDER_RELAXED);
+        }
+
+        T* TryEliminatePop(BackoffType& backoff)
+        {
+            Atomic<std::uintptr_t>& slot = mSlots[backoff.NextSlot()].value;
+            std::uintptr_t state = slot.Load(MEMORY_ORDER_RELAXED);
+
+            // Take node offered by a Push
+            if (state != EMPTY && (state & DELIVERED_BIT) == 0)
+            {
+                if (slot.CompareAndSwap(state, EMPTY, MEMORY_ORDER_ACQUIRE))
+                    return reinterpret_cast<T*>(state);
+
+                return nullptr;
+            }
+
+            if (state != EMPTY || !slot.CompareAndSwap(state, WAITING_POP, MEMORY_ORDER_RELAXED))
+                return nullptr;
+
+            // Wait for a Push to deliver a node
+            for (std::uint32_t i = 0; i < SpinCount; ++i)
+            {
+                state = slot.Load(MEMORY_ORDER_ACQUIRE);
+                if (state != WAITING_POP)
+                    return TakeDelivered(slot, state);
+
+                CRUNCH_PAUSE();
+            }
+
+            // Withdraw. Failure means a Push delivered in the meantime.
+            state = WAITING_POP;
+            if (slot.CompareAndSwap(state, EMPTY, MEMORY_ORDER_ACQUIRE))
+                return nullptr;
+
+            return TakeDelivered(slot, state);
+        }
+
+    private:
+        static T* TakeDelivered(Atomic<std::uintptr_t>& slot, std::uintptr_t state)
+        {
+            CRUNCH_ASSERT(state != WAITING_POP && (state & DELIVERED_BIT) != 0);
+            slot.Store(EMPTY, MEMORY_ORDER_RELAXED);
+            return reinterpret_cast<T*>(state & ~DELIVERED_BIT);
+        }
+
+        CacheLineAligned<Atomic<std::uintptr_t>> mSlots[Width];
+    };
+}
+
+}}
+
+#endif
@@ -0,0 +1,64 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#ifndef CRUNCH_CONCURRENCY_EPOCH_HPP
+#define CRUNCH_CONCURRENCY_EPOCH_HPP
+
+#include "crunch/base/noncopyable.hpp"
+#include "crunch/concurrency/api.hpp"
+
+namespace Crunch { namespace Concurrency {
+
+namespace Detail
+{
+    struct EpochRecord;
+
+    /// Give up the calling thread's record so it can be reused. Objects retired by the thread are kept with the record
+    /// and reclaimed by the next owner.
+    CRUNCH_CONCURRENCY_API void ReleaseEpochRecord();
+
+    template<typename T>
+    void DeleteEpochRetired(void* object)
+    {
+        delete static_cast<T*>(object);
+    }
+}
+
+/// Epoch based reclamation.
+/// Threads access shared lock-free structures inside a critical region delimited by Epoch::Guard. Objects that have
+/// been unlinked are passed to Retire, and reclaimed once every thread that was in a critical region at the time has
+/// left it. Unlike hazard pointers, protecting any number of objects costs two stores and a fence per region, but a
+/// thread stalled inside a region blocks all reclamation.
+///
+/// Reference: Fraser. Practical Lock-Freedom. PhD thesis, University of Cambridge 2004.
+class Epoch : NonCopyable
+{
+public:
+    /// Critical region. May be nested.
+    class Guard : NonCopyable
+    {
+    public:
+        CRUNCH_CONCURRENCY_API Guard();
+        CRUNCH_CONCURRENCY_API ~Guard();
+
+    private:
+        Detail::EpochRecord* mRecord;
+    };
+
+    /// Reclaim object once no thread can hold a reference to it. Object must already be unreachable from shared state.
+    CRUNCH_CONCURRENCY_API static void Retire(void* object, void (*reclaim)(void*));
+
+    template<typename T>
+    static void Retire(T* object)
+    {
+        Retire(static_cast<void*>(object), &Detail::DeleteEpochRetired<T>);
+    }
+
+    /// Quiescent state hook. Tries to advance the global epoch and reclaims objects retired by the calling thread that
+    /// are no longer reachable. Must not be called inside a critical region.
+    CRUNCH_CONCURRENCY_API static void Quiesce();
+};
+
+}}
+
+#endif
@@ -25,4 +25,14 @@
 #   error "Unsupported platform"
 #endif
 
+// Acquire fence orders prior loads before subsequent loads and stores. Release fence orders prior loads and stores
+// before subsequent stores. x86 only reorders stores with later loads, so there they only need to stop the compiler.
+#if defined (CRUNCH_ARCH_X86_32) || defined (CRUNCH_ARCH_X86_64)
+#   define CRUNCH_ACQUIRE_FENCE() CRUNCH_COMPILER_FENCE()
+#   define CRUNCH_RELEASE_FENCE() CRUNCH_COMPILER_FENCE()
+#else
+#   define CRUNCH_ACQUIRE_FENCE() CRUNCH_MEMORY_FENCE()
+#   define CRUNCH_RELEASE_FENCE() CRUNCH_MEMORY_FENCE()
+#endif
+
 #endif
@@ -0,0 +1,75 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#ifndef CRUNCH_CONCURRENCY_GRACE_PERIOD_HPP
+#define CRUNCH_CONCURRENCY_GRACE_PERIOD_HPP
+
+#include "crunch/base/noncopyable.hpp"
+#include "crunch/concurrency/api.hpp"
+
+namespace Crunch { namespace Concurrency {
+
+namespace Detail
+{
+    struct GracePeriodRecord;
+
+    template<typename T>
+    void DeleteGracePeriodRetired(void* object)
+    {
+        delete static_cast<T*>(object);
+    }
+}
+
+/// Quiescent state based reclamation.
+/// Registered reader threads access shared objects with no bookkeeping at all, and instead report quiescent states,
+/// points at which they hold no references to shared objects, e.g., between tasks. A retired object is reclaimed
+/// once every registered thread that is online has reported a quiescent state since it was retired. Threads go
+/// offline while blocked so they don't hold up reclamation. Unlike Epoch, reads cost nothing, but a registered
+/// thread that stops reporting quiescent states blocks all reclamation.
+///
+/// MetaScheduler threads are registered while running, report a quiescent state between scheduler run slices, and
+/// are offline while idle.
+///
+/// Reference: McKenney, Slingwine. Read-Copy Update: Using Execution History to Solve Concurrency Problems. 1998.
+class GracePeriod : NonCopyable
+{
+public:
+    /// Registers the calling thread as a reader for the lifetime of the object. May be nested.
+    class Reader : NonCopyable
+    {
+    public:
+        CRUNCH_CONCURRENCY_API Reader();
+        CRUNCH_CONCURRENCY_API ~Reader();
+    };
+
+    /// Takes a registered calling thread offline for the lifetime of the object, i.e., in an extended quiescent
+    /// state. No shared objects may be accessed while offline. May be nested.
+    class Offline : NonCopyable
+    {
+    public:
+        CRUNCH_CONCURRENCY_API Offline();
+        CRUNCH_CONCURRENCY_API ~Offline();
+
+    private:
+        // Null if the thread isn't registered
+        Detail::GracePeriodRecord* mRecord;
+    };
+
+    /// Reclaim object once no reader can hold a reference to it. Object must already be unreachable from shared
+    /// state.
+    CRUNCH_CONCURRENCY_API static void Retire(void* object, void (*reclaim)(void*));
+
+    template<typename T>
+    static void Retire(T* object)
+    {
+        Retire(static_cast<void*>(object), &Detail::DeleteGracePeriodRetired<T>);
+    }
+
+    /// Report quiescent state for the calling thread, and reclaim retired objects whose grace period has elapsed.
+    /// No-op for unregistered threads, apart from reclamation.
+    CRUNCH_CONCURRENCY_API static void Quiesce();
+};
+
+}}
+
+#endif
@@ -0,0 +1,112 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#ifndef CRUNCH_CONCURRENCY_HAZARD_POINTER_HPP
+#define CRUNCH_CONCURRENCY_HAZARD_POINTER_HPP
+
+#include "crunch/base/noncopyable.hpp"
+#include "crunch/concurrency/api.hpp"
+#include "crunch/concurrency/atomic.hpp"
+#include "crunch/concurrency/fence.hpp"
+
+#include <cstdint>
+
+namespace Crunch { namespace Concurrency {
+
+namespace Detail
+{
+    struct HazardPointerRetiredList;
+
+    /// Records are never freed while the process runs, so they can be scanned without locking
+    struct HazardPointerRecord : NonCopyable
+    {
+        HazardPointerRecord()
+            : hazard(nullptr, MEMORY_ORDER_RELAXED)
+            , inUse(1, MEMORY_ORDER_RELAXED)
+            , next(nullptr)
+            , retired(nullptr)
+        {}
+
+        Atomic<void*> hazard;
+        Atomic<std::uint32_t> inUse;
+        HazardPointerRecord* next;
+
+        // Only accessed by the thread holding the record
+        HazardPointerRetiredList* retired;
+    };
+
+    CRUNCH_CONCURRENCY_API HazardPointerRecord* AcquireHazardPointerRecord();
+    CRUNCH_CONCURRENCY_API void ReleaseHazardPointerRecord(HazardPointerRecord* record);
+
+    template<typename T>
+    void DeleteHazardous(void* object)
+    {
+        delete static_cast<T*>(object);
+    }
+}
+
+/// Single hazard pointer owned by the constructing thread for its lifetime.
+/// An object protected by a hazard pointer will not be reclaimed by Retire until the hazard pointer is cleared.
+/// After Set, the caller must verify that the object is still reachable from shared state before dereferencing it.
+///
+/// Reference: Michael. Hazard Pointers: Safe Memory Reclamation for Lock-Free Objects. IEEE TPDS 2004.
+class HazardPointer : NonCopyable
+{
+public:
+    HazardPointer()
+        : mRecord(Detail::AcquireHazardPointerRecord())
+    {}
+
+    ~HazardPointer()
+    {
+        Clear();
+        Detail::ReleaseHazardPointerRecord(mRecord);
+    }
+
+    void Set(void const* object)
+    {
+        mRecord->hazard.Store(const_cast<void*>(object), MEMORY_ORDER_RELAXED);
+
+        // Publish hazard before caller validates. Pairs with the fence before scanning in Retire.
+        CRUNCH_MEMORY_FENCE();
+    }
+
+    void Clear()
+    {
+        mRecord->hazard.Store(nullptr, MEMORY_ORDER_RELEASE);
+    }
+
+    /// Load and protect pointer, retrying until the protected value is still current
+    template<typename T>
+    T* Protect(Atomic<T*> const& source)
+    {
+        T* object = source.Load(MEMORY_ORDER_RELAXED);
+        for (;;)
+        {
+            Set(object);
+            T* const current = source.Load(MEMORY_ORDER_ACQUIRE);
+            if (current == object)
+                return object;
+            object = current;
+        }
+    }
+
+    /// Reclaim object once no hazard pointer protects it. Object must already be unreachable from shared state.
+    CRUNCH_CONCURRENCY_API static void Retire(void* object, void (*reclaim)(void*));
+
+    template<typename T>
+    static void Retire(T* object)
+    {
+        Retire(static_cast<void*>(object), &Detail::DeleteHazardous<T>);
+    }
+
+    /// Attempt to reclaim all objects retired through any record that are no longer protected
+    CRUNCH_CONCURRENCY_API static void ReclaimAll();
+
+private:
+    Detail::HazardPointerRecord* const mRecord;
+};
+
+}}
+
+#endif
@@ -74,8 +74,8 @@ public:
     CRUNCH_CONCURRENCY_API Context& AcquireContext();
 
 private:
-    friend CRUNCH_CONCURRENCY_API void WaitFor(IWaitable&, WaitMode);
-    friend CRUNCH_CONCURRENCY_API void WaitForAll(IWaitable**, std::size_t, WaitMode);
+    friend CRUNCH_CONCURRENCY_API bool WaitFor(IWaitable&, WaitMode);
+    friend CRUNCH_CONCURRENCY_API bool WaitForAll(IWaitable**, std::size_t, WaitMode);
     friend CRUNCH_CONCURRENCY_API WaitForAnyResult WaitForAny(IWaitable**, std::size_t, WaitMode);
 
     friend class Config;
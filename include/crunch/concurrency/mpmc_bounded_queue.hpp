@@ -0,0 +1,147 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#ifndef CRUNCH_CONCURRENCY_MPMC_BOUNDED_QUEUE_HPP
+#define CRUNCH_CONCURRENCY_MPMC_BOUNDED_QUEUE_HPP
+
+#include "crunch/base/noncopyable.hpp"
+#include "crunch/concurrency/atomic.hpp"
+#include "crunch/concurrency/detail/cache_line.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace Crunch { namespace Concurrency {
+
+/// Bounded multi-producer multi-consumer FIFO queue on a ring buffer.
+/// Each cell carries a sequence number telling producers and consumers whether it is free for the current lap, so
+/// the only shared writes are one CAS on the enqueue or dequeue position per operation. No allocation after
+/// construction. The move constructor of T must not throw.
+///
+/// Reference: Vyukov. Bounded MPMC queue. http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+template<typename T>
+class MPMCBoundedQueue : NonCopyable
+{
+public:
+    /// \param capacityLog2 Log2 of the maximum number of items in the queue
+    MPMCBoundedQueue(std::uint32_t capacityLog2)
+        : mMask((std::size_t(1) << capacityLog2) - 1)
+        , mCells(new Cell[mMask + 1])
+    {
+        for (std::size_t i = 0; i <= mMask; ++i)
+            mCells[i].sequence.Store(i, MEMORY_ORDER_RELAXED);
+
+        mEnqueuePosition.value.Store(0, MEMORY_ORDER_RELAXED);
+        mDequeuePosition.value.Store(0, MEMORY_ORDER_RELEASE);
+    }
+
+    ~MPMCBoundedQueue()
+    {
+        std::size_t const end = mEnqueuePosition.value.Load(MEMORY_ORDER_ACQUIRE);
+        for (std::size_t position = mDequeuePosition.value.Load(MEMORY_ORDER_ACQUIRE); position != end; ++position)
+            reinterpret_cast<T&>(mCells[position & mMask].storage).~T();
+
+        delete [] mCells;
+    }
+
+    std::size_t GetCapacity() const
+    {
+        return mMask + 1;
+    }
+
+    /// \return false if full
+    template<typename TT>
+    bool TryPush(TT&& value)
+    {
+        Cell* cell;
+        std::size_t position = mEnqueuePosition.value.Load(MEMORY_ORDER_RELAXED);
+        for (;;)
+        {
+            cell = &mCells[position & mMask];
+            std::size_t const sequence = cell->sequence.Load(MEMORY_ORDER_ACQUIRE);
+            std::ptrdiff_t const difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+
+            if (difference == 0)
+            {
+                // Cell free for this lap. Claim it.
+                if (mEnqueuePosition.value.CompareAndSwap(position, position + 1, MEMORY_ORDER_RELAXED))
+                    break;
+            }
+            else if (difference < 0)
+            {
+                // Cell still holds the item from the previous lap
+                return false;
+            }
+            else
+            {
+                // Another producer claimed the cell
+                position = mEnqueuePosition.value.Load(MEMORY_ORDER_RELAXED);
+            }
+        }
+
+        ::new (&cell->storage) T(std::forward<TT>(value));
+        cell->sequence.Store(position + 1, MEMORY_ORDER_RELEASE);
+        return true;
+    }
+
+    /// \return false if empty
+    bool TryPop(T& outValue)
+    {
+        Cell* cell;
+        std::size_t position = mDequeuePosition.value.Load(MEMORY_ORDER_RELAXED);
+        for (;;)
+        {
+            cell = &mCells[position & mMask];
+            std::size_t const sequence = cell->sequence.Load(MEMORY_ORDER_ACQUIRE);
+            std::ptrdiff_t const difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+
+            if (difference == 0)
+            {
+                // Cell holds item for this lap. Claim it.
+                if (mDequeuePosition.value.CompareAndSwap(position, position + 1, MEMORY_ORDER_RELAXED))
+                    break;
+            }
+            else if (difference < 0)
+            {
+                // Cell not yet written for this lap
+                return false;
+            }
+            else
+            {
+                // Another consumer claimed the cell
+                position = mDequeuePosition.value.Load(MEMORY_ORDER_RELAXED);
+            }
+        }
+
+        T& value = reinterpret_cast<T&>(cell->storage);
+        outValue = std::move(value);
+        value.~T();
+
+        // Free cell for the producer of the next lap
+        cell->sequence.Store(position + mMask + 1, MEMORY_ORDER_RELEASE);
+        return true;
+    }
+
+private:
+    struct Cell
+    {
+        typedef typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type StorageType;
+
+        Atomic<std::size_t> sequence;
+        StorageType storage;
+    };
+
+    std::size_t const mMask;
+    Cell* const mCells;
+
+    // Producers and consumers each get their own cache line, apart from the read-only state above
+    Detail::CacheLineAligned<Atomic<std::size_t>> mEnqueuePosition;
+    Detail::CacheLineAligned<Atomic<std::size_t>> mDequeuePosition;
+};
+
+}}
+
+#endif
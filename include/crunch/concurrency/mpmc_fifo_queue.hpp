@@ -0,0 +1,315 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#ifndef CRUNCH_CONCURRENCY_MPMC_FIFO_QUEUE_HPP
+#define CRUNCH_CONCURRENCY_MPMC_FIFO_QUEUE_HPP
+
+#include "crunch/base/assert.hpp"
+#include "crunch/base/noncopyable.hpp"
+#include "crunch/concurrency/atomic.hpp"
+#include "crunch/concurrency/epoch.hpp"
+#include "crunch/concurrency/exponential_backoff.hpp"
+#include "crunch/concurrency/mpmc_lifo_list.hpp"
+#include "crunch/concurrency/yield.hpp"
+#include "crunch/concurrency/detail/cache_line.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace Crunch { namespace Concurrency {
+
+namespace Detail
+{
+    template<typename T, std::uint32_t SegmentSize>
+    struct MPMCFifoQueueSegment;
+
+    /// Free segments shared between a queue and segments retired by it. Outlives the queue if retired segments are
+    /// still pending reclamation when it is destroyed.
+    template<typename T, std::uint32_t SegmentSize>
+    struct MPMCFifoQueueSegmentPool : NonCopyable
+    {
+        typedef MPMCFifoQueueSegment<T, SegmentSize> Segment;
+
+        MPMCFifoQueueSegmentPool()
+            : refCount(1, MEMORY_ORDER_RELAXED)
+        {}
+
+        ~MPMCFifoQueueSegmentPool()
+        {
+            while (Segment* segment = freeSegments.Pop())
+                delete segment;
+        }
+
+        Segment* Allocate()
+        {
+            Segment* segment = freeSegments.Pop();
+            if (segment == nullptr)
+                segment = new Segment(this);
+
+            segment->Reset();
+            return segment;
+        }
+
+        void AddRef()
+        {
+            refCount.Increment(MEMORY_ORDER_RELAXED);
+        }
+
+        void Release()
+        {
+            if (refCount.Decrement(MEMORY_ORDER_ACQ_REL) == 1)
+                delete this;
+        }
+
+        // Segments are never freed while the pool is in use, so ABA tagging alone protects Pop
+        MPMCLifoList<Segment, ExponentialBackoff, ReclamationPolicyNone> freeSegments;
+        Atomic<std::uint32_t> refCount;
+    };
+
+    template<typename T, std::uint32_t SegmentSize>
+    struct MPMCFifoQueueSegment : NonCopyable
+    {
+        typedef MPMCFifoQueueSegmentPool<T, SegmentSize> Pool;
+        typedef typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type StorageType;
+
+        // Cell states. Cells move from EMPTY to either TAKEN, when a dequeuer overtakes the enqueuer that claimed the
+        // index, or through WRITING to FULL.
+        static std::uint32_t const EMPTY = 0;
+        static std::uint32_t const WRITING = 1;
+        static std::uint32_t const FULL = 2;
+        static std::uint32_t const TAKEN = 3;
+
+        struct Cell
+        {
+            Atomic<std::uint32_t> state;
+            StorageType storage;
+        };
+
+        MPMCFifoQueueSegment(Pool* pool)
+            : pool(pool)
+        {}
+
+        // Keep the indices on cache lines of their own
+        static void* operator new(std::size_t size)
+        {
+            return AllocateCacheLineAligned(size);
+        }
+
+        static void operator delete(void* allocation)
+        {
+            FreeCacheLineAligned(allocation);
+        }
+
+        void Reset()
+        {
+            for (std::uint32_t i = 0; i < SegmentSize; ++i)
+                cells[i].state.Store(EMPTY, MEMORY_ORDER_RELAXED);
+
+            enqueueIndex.value.Store(0, MEMORY_ORDER_RELAXED);
+            dequeueIndex.value.Store(0, MEMORY_ORDER_RELAXED);
+            next.Store(nullptr, MEMORY_ORDER_RELAXED);
+        }
+
+        /// Epoch reclaim function. Returns segment to the pool it came from.
+        static void Recycle(void* object)
+        {
+            MPMCFifoQueueSegment* const segment = static_cast<MPMCFifoQueueSegment*>(object);
+            Pool* const owner = segment->pool;
+            owner->freeSegments.Push(segment);
+            owner->Release();
+        }
+
+        Detail::CacheLineAligned<Atomic<std::uint32_t>> enqueueIndex;
+        Detail::CacheLineAligned<Atomic<std::uint32_t>> dequeueIndex;
+        Atomic<MPMCFifoQueueSegment*> next;
+        MPMCFifoQueueSegment* freeNext;
+        Pool* const pool;
+        Cell cells[SegmentSize];
+    };
+
+    template<typename T, std::uint32_t SegmentSize>
+    void SetNext(MPMCFifoQueueSegment<T, SegmentSize>& segment, MPMCFifoQueueSegment<T, SegmentSize>* next)
+    {
+        segment.freeNext = next;
+    }
+
+    template<typename T, std::uint32_t SegmentSize>
+    MPMCFifoQueueSegment<T, SegmentSize>* GetNext(MPMCFifoQueueSegment<T, SegmentSize> const& segment)
+    {
+        return segment.freeNext;
+    }
+}
+
+/// Unbounded multi-producer multi-consumer FIFO queue of linked fixed size ring segments.
+/// Enqueuers and dequeuers claim cells with a fetch-and-add on the segment's index rather than contending on a CAS.
+/// A dequeuer that overtakes an enqueuer marks the cell taken and both retry on the next index. Once a segment runs
+/// out of indices, a new one is linked behind it. Segments are accessed inside an Epoch::Guard, and drained segments
+/// are retired through the epoch and then recycled through a free list rather than freed.
+///
+/// Entering the epoch region costs a fence per operation. A dequeuer that reaches a cell whose enqueuer is still
+/// constructing the value waits for it, so the queue is lock free only in the absence of preemption inside Push.
+/// The move constructor of T must not throw.
+///
+/// Reference: Morrison, Afek. Fast Concurrent Queues for x86 Processors. PPoPP 2013.
+template<typename T, std::uint32_t SegmentSize = 1024>
+class MPMCFifoQueue : NonCopyable
+{
+public:
+    MPMCFifoQueue()
+        : mPool(new Pool())
+    {
+        Segment* const segment = mPool->Allocate();
+        mHead.value.Store(segment, MEMORY_ORDER_RELAXED);
+        mTail.value.Store(segment, MEMORY_ORDER_RELEASE);
+    }
+
+    ~MPMCFifoQueue()
+    {
+        // Destroy remaining items and return the live segments to the pool
+        Segment* segment = mHead.value.Load(MEMORY_ORDER_ACQUIRE);
+        while (segment != nullptr)
+        {
+            for (std::uint32_t i = 0; i < SegmentSize; ++i)
+            {
+                if (segment->cells[i].state.Load(MEMORY_ORDER_RELAXED) == Segment::FULL)
+                    reinterpret_cast<T&>(segment->cells[i].storage).~T();
+            }
+
+            Segment* const next = segment->next.Load(MEMORY_ORDER_RELAXED);
+            mPool->freeSegments.Push(segment);
+            segment = next;
+        }
+
+        mPool->Release();
+    }
+
+    template<typename TT>
+    void Push(TT&& value)
+    {
+        Epoch::Guard guard;
+        for (;;)
+        {
+            Segment* const tail = mTail.value.Load(MEMORY_ORDER_ACQUIRE);
+            std::uint32_t const index = tail->enqueueIndex.value.Increment(MEMORY_ORDER_RELAXED);
+            if (index < SegmentSize)
+            {
+                typename Segment::Cell& cell = tail->cells[index];
+                std::uint32_t state = Segment::EMPTY;
+                if (cell.state.CompareAndSwap(state, Segment::WRITING, MEMORY_ORDER_RELAXED))
+                {
+                    ::new (&cell.storage) T(std::forward<TT>(value));
+                    cell.state.Store(Segment::FULL, MEMORY_ORDER_RELEASE);
+                    return;
+                }
+
+                // Overtaken by a dequeuer
+                continue;
+            }
+
+            // Segment full. Help an enqueuer that linked a new segment but hasn't moved the tail yet.
+            Segment* next = tail->next.Load(MEMORY_ORDER_ACQUIRE);
+            if (next != nullptr)
+            {
+                Segment* expectedTail = tail;
+                mTail.value.CompareAndSwap(expectedTail, next, MEMORY_ORDER_RELEASE);
+                continue;
+            }
+
+            // Link a new segment with the first cell reserved for this item
+            Segment* const segment = mPool->Allocate();
+            segment->enqueueIndex.value.Store(1, MEMORY_ORDER_RELAXED);
+            segment->cells[0].state.Store(Segment::WRITING, MEMORY_ORDER_RELAXED);
+
+            if (tail->next.CompareAndSwap(next, segment, MEMORY_ORDER_RELEASE))
+            {
+                Segment* expectedTail = tail;
+                mTail.value.CompareAndSwap(expectedTail, segment, MEMORY_ORDER_RELEASE);
+
+                ::new (&segment->cells[0].storage) T(std::forward<TT>(value));
+                segment->cells[0].state.Store(Segment::FULL, MEMORY_ORDER_RELEASE);
+                return;
+            }
+
+            // Never published, so no other thread can have seen it
+            mPool->freeSegments.Push(segment);
+        }
+    }
+
+    /// \return false if empty
+    bool TryPop(T& outValue)
+    {
+        Epoch::Guard guard;
+        for (;;)
+        {
+            Segment* const head = mHead.value.Load(MEMORY_ORDER_ACQUIRE);
+
+            // Don't burn indices when there is nothing to take
+            if (head->dequeueIndex.value.Load(MEMORY_ORDER_RELAXED) >= head->enqueueIndex.value.Load(MEMORY_ORDER_ACQUIRE) &&
+                head->next.Load(MEMORY_ORDER_ACQUIRE) == nullptr)
+            {
+                return false;
+            }
+
+            std::uint32_t const index = head->dequeueIndex.value.Increment(MEMORY_ORDER_RELAXED);
+            if (index >= SegmentSize)
+            {
+                // Segment drained. Move on if there is a next one.
+                Segment* const next = head->next.Load(MEMORY_ORDER_ACQUIRE);
+                if (next == nullptr)
+                    return false;
+
+                // The enqueuer that linked next may not have moved the tail yet. Move it off the segment before
+                // retiring, or enqueuers entering a later epoch could still reach it through the tail.
+                Segment* expectedTail = head;
+                mTail.value.CompareAndSwap(expectedTail, next, MEMORY_ORDER_RELEASE);
+
+                Segment* expectedHead = head;
+                if (mHead.value.CompareAndSwap(expectedHead, next, MEMORY_ORDER_RELEASE))
+                {
+                    mPool->AddRef();
+                    Epoch::Retire(head, &Segment::Recycle);
+                }
+                continue;
+            }
+
+            typename Segment::Cell& cell = head->cells[index];
+            std::uint32_t state = Segment::EMPTY;
+            if (cell.state.CompareAndSwap(state, Segment::TAKEN, MEMORY_ORDER_ACQUIRE))
+            {
+                // Overtook the enqueuer. It will retry on another index.
+                continue;
+            }
+
+            // Enqueuer is constructing the value
+            while (state == Segment::WRITING)
+            {
+                CRUNCH_PAUSE();
+                state = cell.state.Load(MEMORY_ORDER_ACQUIRE);
+            }
+
+            CRUNCH_ASSERT(state == Segment::FULL);
+            T& value = reinterpret_cast<T&>(cell.storage);
+            outValue = std::move(value);
+            value.~T();
+
+            // Let the destructor know the cell is empty
+            cell.state.Store(Segment::TAKEN, MEMORY_ORDER_RELAXED);
+            return true;
+        }
+    }
+
+private:
+    typedef Detail::MPMCFifoQueueSegment<T, SegmentSize> Segment;
+    typedef Detail::MPMCFifoQueueSegmentPool<T, SegmentSize> Pool;
+
+    Pool* const mPool;
+    Detail::CacheLineAligned<Atomic<Segment*>> mHead;
+    Detail::CacheLineAligned<Atomic<Segment*>> mTail;
+};
+
+}}
+
+#endif
@@ -5,42 +5,73 @@
 #define CRUNCH_CONCURRENCY_MPMC_LIFO_LIST_HPP
 
 #include "crunch/concurrency/atomic.hpp"
+#include "crunch/concurrency/elimination_backoff.hpp"
 #include "crunch/concurrency/exponential_backoff.hpp"
-
-#include <cstdint>
+#include "crunch/concurrency/reclamation_policy.hpp"
+#include "crunch/concurrency/tagged_pointer.hpp"
 
 namespace Crunch { namespace Concurrency {
 
-struct ReclamationPolicyNone;
-struct ReclamationPolicyAccessViolationChecked;
-
 /// The following functions must be available by ADL
 ///     void SetNext(T&, T*)
 ///     T* GetNext(T const&)
-//     
-// TODO: Memory reclamation policy
-template<typename T, typename BackoffPolicy = ExponentialBackoff, typename ReclamationPolicy = ReclamationPolicyAccessViolationChecked>
-class MPMCLifoList
+///
+/// With ReclamationPolicyHazardPointer or ReclamationPolicyEpoch, popped nodes may be freed through the policy's
+/// Retire. With the other policies, nodes must not be freed while other threads may be popping.
+///
+/// TaggedPointerPolicy selects the root representation. DoubleWidthTaggedPointerPolicy lifts the 48 bit address space
+/// assumption and 16 bit ABA tag of the default packed representation, at the cost of a double width CAS.
+///
+/// With EliminationBackoff, a Push and a Pop that collide on the root may complete by exchanging the node directly.
+template<
+    typename T,
+    typename BackoffPolicy = ExponentialBackoff,
+    typename ReclamationPolicy = ReclamationPolicyAccessViolationChecked,
+    typename TaggedPointerPolicy = PackedTaggedPointerPolicy>
+class MPMCLifoList : private Detail::EliminationArray<BackoffPolicy, T>
 {
+    // Held as a base so the empty array of ordinary backoff policies takes no space
+    typedef Detail::EliminationArray<BackoffPolicy, T> Elimination;
+
 public:
     MPMCLifoList()
-        : mRoot(0, MEMORY_ORDER_RELEASE)
+        : mRoot(Root::Null(), MEMORY_ORDER_RELEASE)
     {}
     
     void Push(T* node)
     {
         BackoffPolicy backoff;
-        std::uint64_t oldRoot = mRoot.Load(MEMORY_ORDER_RELAXED);
-        std::uint64_t const newRootPtrAndAddend = reinterpret_cast<std::uint64_t>(node) + ABA_ADDEND;
+        RootValue oldRoot = mRoot.Load(MEMORY_ORDER_RELAXED);
 
         for (;;)
         {
             // Set next pointer in node
-            SetNext(*node, reinterpret_cast<T*>(oldRoot & PTR_MASK));
+            SetNext(*node, Root::GetPointer(oldRoot));
 
             // Try to update current root node
-            std::uint64_t const newRoot = newRootPtrAndAddend + (oldRoot & ABA_MASK);
-            if (mRoot.CompareAndSwap(oldRoot, newRoot, MEMORY_ORDER_RELEASE))
+            if (mRoot.CompareAndSwap(oldRoot, Root::Replace(oldRoot, node), MEMORY_ORDER_RELEASE))
+                break;
+
+            if (Elimination::TryEliminatePush(backoff, node))
+                break;
+
+            backoff.Pause();
+        }
+    }
+
+    /// Push a pre-linked chain of nodes in a single operation
+    /// \param first Node that becomes the new top
+    /// \param last Last node of the chain, reachable from first through GetNext
+    void PushChain(T* first, T* last)
+    {
+        BackoffPolicy backoff;
+        RootValue oldRoot = mRoot.Load(MEMORY_ORDER_RELAXED);
+
+        for (;;)
+        {
+            SetNext(*last, Root::GetPointer(oldRoot));
+
+            if (mRoot.CompareAndSwap(oldRoot, Root::Replace(oldRoot, first), MEMORY_ORDER_RELEASE))
                 break;
 
             backoff.Pause();
@@ -50,19 +81,45 @@ public:
     T* Pop()
     {
         BackoffPolicy backoff;
-        std::uint64_t oldRoot = mRoot.Load(MEMORY_ORDER_RELAXED);
+        typename ReclamationPolicy::Guard guard;
+        RootValue oldRoot = mRoot.Load(MEMORY_ORDER_RELAXED);
 
         for (;;)
         {
-            T* const oldRootPtr = reinterpret_cast<T*>(oldRoot & PTR_MASK);
+            T* const oldRootPtr = Root::GetPointer(oldRoot);
             if (oldRootPtr == nullptr)
                 return nullptr;
 
-            std::uint64_t const newRoot =
-                reinterpret_cast<std::uint64_t>(GetNext(*oldRootPtr)) +
-                (oldRoot & ABA_MASK) + ABA_ADDEND;
-            
-            if (mRoot.CompareAndSwap(oldRoot, newRoot, MEMORY_ORDER_RELEASE))
+            // Root may have been popped and reclaimed since it was loaded
+            if (!guard.Protect(oldRootPtr, mRoot, oldRoot))
+                continue;
+
+            if (mRoot.CompareAndSwap(oldRoot, Root::Replace(oldRoot, GetNext(*oldRootPtr)), MEMORY_ORDER_RELEASE))
+                return oldRootPtr;
+
+            if (T* const node = Elimination::TryEliminatePop(backoff))
+                return node;
+
+            backoff.Pause();
+        }
+    }
+
+    /// Remove all nodes in a single operation
+    /// \return Most recently pushed node, linked through GetNext, or nullptr if empty
+    T* PopAll()
+    {
+        BackoffPolicy backoff;
+        RootValue oldRoot = mRoot.Load(MEMORY_ORDER_RELAXED);
+
+        // Doesn't dereference nodes, so no reclamation guard needed. The tag is still advanced rather than reset
+        // to protect concurrent Pops from ABA.
+        for (;;)
+        {
+            T* const oldRootPtr = Root::GetPointer(oldRoot);
+            if (oldRootPtr == nullptr)
+                return nullptr;
+
+            if (mRoot.CompareAndSwap(oldRoot, Root::Replace(oldRoot, nullptr), MEMORY_ORDER_ACQUIRE))
                 return oldRootPtr;
 
             backoff.Pause();
@@ -70,17 +127,10 @@ public:
     }
 
 private:
-#if (CRUNCH_PTR_SIZE == 4)
-    static std::uint64_t const PTR_MASK   = 0x00000000ffffffffull;
-    static std::uint64_t const ABA_MASK   = 0xffffffff00000000ull;
-    static std::uint64_t const ABA_ADDEND = 0x0000000100000000ull;
-#else
-    // Assume 48 bit address space
-    static std::uint64_t const PTR_MASK   = 0x0000ffffffffffffull;
-    static std::uint64_t const ABA_MASK   = 0xffff000000000000ull;
-    static std::uint64_t const ABA_ADDEND = 0x0001000000000000ull;
-#endif
-    Atomic<std::uint64_t> mRoot;
+    typedef typename TaggedPointerPolicy::template Root<T> Root;
+    typedef typename Root::ValueType RootValue;
+
+    Atomic<RootValue> mRoot;
 };
 
 }}
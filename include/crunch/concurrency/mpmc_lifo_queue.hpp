@@ -53,7 +53,7 @@ public:
         if (!node)
             node = new Node();
 
-        new (&node->storage) T(std::forward<T>(value));
+        new (&node->storage) T(std::forward<TT>(value));
         node->next = nullptr;
 
         mQueueNodes.Push(node);
@@ -69,6 +69,7 @@ public:
         outValue = std::move(value);
         value.~T();
         mFreeNodes.Push(node);
+        return true;
     }
 
 private:
@@ -0,0 +1,140 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#ifndef CRUNCH_CONCURRENCY_MPSC_FIFO_LIST_HPP
+#define CRUNCH_CONCURRENCY_MPSC_FIFO_LIST_HPP
+
+#include "crunch/base/noncopyable.hpp"
+#include "crunch/concurrency/atomic.hpp"
+#include "crunch/concurrency/fence.hpp"
+#include "crunch/concurrency/waitable.hpp"
+#include "crunch/concurrency/detail/cache_line.hpp"
+#include "crunch/concurrency/detail/condition_waitable.hpp"
+
+namespace Crunch { namespace Concurrency {
+
+/// Intrusive multi-producer single-consumer FIFO list. Push is wait free, Pop is lock free.
+/// The following functions must be available by ADL
+///     void SetNext(T&, T*)
+///     T* GetNext(T const&)
+///
+/// T must be default constructible, as the list embeds a stub node. Nodes are owned by the caller and must stay
+/// alive until popped. Links are accessed with plain loads and stores between compiler fences, relying on the
+/// hardware ordering of stores, as for MPMCLifoList.
+///
+/// A producer that is preempted between swapping the head and linking its node hides every node pushed after it from
+/// the consumer until it resumes. Pop returns nullptr while in that state even though the list is not empty.
+///
+/// Reference: Vyukov. Intrusive MPSC node-based queue.
+/// http://www.1024cores.net/home/lock-free-algorithms/queues/intrusive-mpsc-node-based-queue
+template<typename T>
+class MPSCFifoList : NonCopyable
+{
+public:
+    MPSCFifoList()
+        : mNotEmpty(&MPSCFifoList::IsNotEmpty, this)
+    {
+        SetNext(mConsumer.value.stub, nullptr);
+        mConsumer.value.tail = &mConsumer.value.stub;
+        mHead.value.Store(&mConsumer.value.stub, MEMORY_ORDER_RELEASE);
+    }
+
+    /// Ready when there are nodes to pop. Only the consumer may wait on it.
+    IWaitable& GetNotEmptyCondition()
+    {
+        return mNotEmpty;
+    }
+
+    void Push(T* node)
+    {
+        Link(node);
+        mNotEmpty.Notify();
+    }
+
+    /// Consumer only
+    /// \return Oldest node, or nullptr if empty
+    T* Pop()
+    {
+        T* stub = &mConsumer.value.stub;
+        T* tail = mConsumer.value.tail;
+        T* next = LoadNext(*tail);
+
+        // Skip past the stub
+        if (tail == stub)
+        {
+            if (next == nullptr)
+                return nullptr;
+
+            mConsumer.value.tail = next;
+            tail = next;
+            next = LoadNext(*next);
+        }
+
+        if (next != nullptr)
+        {
+            mConsumer.value.tail = next;
+            return tail;
+        }
+
+        // A producer has swapped the head but not yet linked its node
+        if (tail != mHead.value.Load(MEMORY_ORDER_ACQUIRE))
+            return nullptr;
+
+        // Tail is the last node. Push the stub behind it so the tail can move on without leaving the list headless.
+        Link(stub);
+
+        next = LoadNext(*tail);
+        if (next != nullptr)
+        {
+            mConsumer.value.tail = next;
+            return tail;
+        }
+
+        return nullptr;
+    }
+
+    /// Consumer only
+    bool IsEmpty() const
+    {
+        T const* const stub = &mConsumer.value.stub;
+        return mConsumer.value.tail == stub && mHead.value.Load(MEMORY_ORDER_ACQUIRE) == stub;
+    }
+
+private:
+    struct ConsumerState
+    {
+        T* tail;
+        T stub;
+    };
+
+    static T* LoadNext(T& node)
+    {
+        CRUNCH_COMPILER_FENCE();
+        T* const next = GetNext(node);
+        CRUNCH_COMPILER_FENCE();
+        return next;
+    }
+
+    void Link(T* node)
+    {
+        SetNext(*node, nullptr);
+        T* const prev = mHead.value.Swap(node);
+
+        // Publish node to the consumer
+        CRUNCH_COMPILER_FENCE();
+        SetNext(*prev, node);
+    }
+
+    static bool IsNotEmpty(void const* context)
+    {
+        return !static_cast<MPSCFifoList const*>(context)->IsEmpty();
+    }
+
+    Detail::ConditionWaitable mNotEmpty;
+    Detail::CacheLineAligned<Atomic<T*>> mHead;
+    Detail::CacheLineAligned<ConsumerState> mConsumer;
+};
+
+}}
+
+#endif
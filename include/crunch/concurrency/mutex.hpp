@@ -12,13 +12,26 @@
 
 namespace Crunch { namespace Concurrency {
 
-// Simple non-fair mutex. Will give lock to waiters in LIFO order.
+// Simple mutex with two modes of operation.
+// MODE_UNFAIR: Will give lock to waiters in LIFO order. Cheapest handoff, but the oldest waiters may starve.
+// MODE_FAIR: Will give lock to waiters in FIFO order. Unlock finds the oldest waiter by walking the waiter list.
+// Lock spins for a fixed number of times before waiting, or with ADAPTIVE_SPIN for a budget learnt from how long
+// recent spinning took to succeed.
 class Mutex : public IWaitable
 {
 public:
     using IWaitable::AddWaiter;
 
-    CRUNCH_CONCURRENCY_API Mutex(std::uint32_t spinCount = 0);
+    enum Mode
+    {
+        MODE_UNFAIR, ///< Lock handed to newest waiter
+        MODE_FAIR    ///< Lock handed to oldest waiter
+    };
+
+    static std::uint32_t const ADAPTIVE_SPIN = 0xfffffffful;
+
+    /// \param spinCount Number of times Lock retries before waiting, or ADAPTIVE_SPIN
+    CRUNCH_CONCURRENCY_API Mutex(std::uint32_t spinCount = 0, Mode mode = MODE_UNFAIR);
 
     CRUNCH_CONCURRENCY_API void Lock();
     
@@ -35,8 +48,23 @@ private:
     // locked bit when building waiter list
     static std::uint64_t const MUTEX_FREE_BIT = Detail::WaiterList::USER_FLAG_BIT;
 
+    // Bounds of adaptive spinning. Always spin a little to find out if the budget should grow.
+    static std::uint32_t const MIN_ADAPTIVE_SPIN_COUNT = 16;
+    static std::uint32_t const MAX_ADAPTIVE_SPIN_COUNT = 4000;
+
+    /// \return Number of retries before the lock was taken, or spinCount if it wasn't
+    std::uint32_t SpinLock(std::uint32_t spinCount);
+
+    /// Hand the lock to the oldest waiter. Head has a waiter other than the oldest.
+    /// \return false if head changed
+    bool TryHandOffToOldest(std::uint64_t& head);
+
     Detail::WaiterList mWaiters;
     std::uint32_t mSpinCount;
+    Mode mMode;
+
+    // Moving average of retries needed by recent Lock calls, counting a failed spin as 0
+    Atomic<std::uint32_t> mSpinBudget;
 };
 
 }}
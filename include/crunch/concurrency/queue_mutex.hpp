@@ -0,0 +1,69 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#ifndef CRUNCH_CONCURRENCY_QUEUE_MUTEX_HPP
+#define CRUNCH_CONCURRENCY_QUEUE_MUTEX_HPP
+
+#include "crunch/base/noncopyable.hpp"
+#include "crunch/base/override.hpp"
+#include "crunch/concurrency/api.hpp"
+#include "crunch/concurrency/atomic.hpp"
+#include "crunch/concurrency/waitable.hpp"
+
+#include <cstdint>
+
+namespace Crunch { namespace Concurrency {
+
+namespace Detail
+{
+    struct QueueMutexNode;
+
+    /// Return the queue mutex nodes cached by the calling thread to the shared pool. Called on thread exit.
+    CRUNCH_CONCURRENCY_API void ReleaseQueueMutexNodeCache();
+}
+
+/// Fair mutex that queues lockers in FIFO order. Every locker enqueues a node of its own and spins, then sleeps, on
+/// that node's cache line only, and the owner hands the lock directly to its successor on release. Unlike Mutex, a
+/// contended handoff touches just the owner's and the successor's nodes rather than a line shared by all waiters.
+///
+/// Reference: Mellor-Crummey, Scott. Algorithms for Scalable Synchronization on Shared-Memory Multiprocessors. 1991.
+class QueueMutex : public IWaitable, NonCopyable
+{
+public:
+    using IWaitable::AddWaiter;
+
+    /// \param spinCount Number of times Lock checks for handoff before going to sleep
+    CRUNCH_CONCURRENCY_API QueueMutex(std::uint32_t spinCount = 100);
+
+    CRUNCH_CONCURRENCY_API void Lock();
+
+    CRUNCH_CONCURRENCY_API void Unlock();
+
+    CRUNCH_CONCURRENCY_API bool IsLocked() const;
+
+    /// Waiter is notified when it has been handed the lock. Uses waiter->next until then.
+    CRUNCH_CONCURRENCY_API CRUNCH_MUST_CHECK_RESULT virtual bool AddWaiter(Waiter* waiter) CRUNCH_OVERRIDE;
+
+    /// Withdrawn waiters stay queued, and are skipped when they reach the head
+    CRUNCH_CONCURRENCY_API CRUNCH_MUST_CHECK_RESULT virtual bool RemoveWaiter(Waiter* waiter) CRUNCH_OVERRIDE;
+
+    CRUNCH_CONCURRENCY_API virtual bool IsOrderDependent() const CRUNCH_OVERRIDE;
+
+private:
+    typedef Detail::QueueMutexNode Node;
+
+    /// \return false if the lock was free and is now held through node
+    bool Enqueue(Node* node);
+
+    // Last node in the queue, or null if unlocked
+    Atomic<Node*> mTail;
+
+    // Node of the current owner. Only accessed by the owner, and by the thread handing it the lock.
+    Node* mHolder;
+
+    std::uint32_t mSpinCount;
+};
+
+}}
+
+#endif
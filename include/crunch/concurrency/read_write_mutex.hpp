@@ -0,0 +1,107 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#ifndef CRUNCH_CONCURRENCY_READ_WRITE_MUTEX_HPP
+#define CRUNCH_CONCURRENCY_READ_WRITE_MUTEX_HPP
+
+#include "crunch/base/noncopyable.hpp"
+#include "crunch/base/override.hpp"
+#include "crunch/concurrency/api.hpp"
+#include "crunch/concurrency/atomic.hpp"
+#include "crunch/concurrency/detail/cache_line.hpp"
+#include "crunch/concurrency/detail/waiter_list.hpp"
+
+#include <cstdint>
+
+namespace Crunch { namespace Concurrency {
+
+/// Shared/exclusive lock for read-mostly data, with writer preference.
+/// Readers count themselves in one of a set of per-thread slots on separate cache lines, so uncontended shared
+/// locking doesn't bounce a shared counter between cores. A writer announces itself with a flag that turns new
+/// readers away, and then waits for the slots to drain. Blocked readers are admitted together when the writer leaves.
+///
+/// The mutex itself is the exclusive waitable. GetShared() gives the shared one, e.g., for LockGuard or WaitForAll.
+class ReadWriteMutex : public IWaitable, NonCopyable
+{
+public:
+    using IWaitable::AddWaiter;
+
+    class Shared : public IWaitable, NonCopyable
+    {
+    public:
+        using IWaitable::AddWaiter;
+
+        CRUNCH_CONCURRENCY_API void Lock();
+        CRUNCH_CONCURRENCY_API void Unlock();
+
+        CRUNCH_CONCURRENCY_API CRUNCH_MUST_CHECK_RESULT virtual bool AddWaiter(Waiter* waiter) CRUNCH_OVERRIDE;
+        CRUNCH_CONCURRENCY_API CRUNCH_MUST_CHECK_RESULT virtual bool RemoveWaiter(Waiter* waiter) CRUNCH_OVERRIDE;
+        CRUNCH_CONCURRENCY_API virtual bool IsOrderDependent() const CRUNCH_OVERRIDE;
+
+    private:
+        friend class ReadWriteMutex;
+
+        Shared(ReadWriteMutex& owner) : mOwner(owner) {}
+
+        ReadWriteMutex& mOwner;
+    };
+
+    CRUNCH_CONCURRENCY_API ReadWriteMutex();
+
+    CRUNCH_CONCURRENCY_API void Lock();
+    CRUNCH_CONCURRENCY_API void Unlock();
+
+    /// \return false if a writer holds or waits for the lock
+    CRUNCH_CONCURRENCY_API bool TryLockShared();
+    CRUNCH_CONCURRENCY_API void LockShared();
+    CRUNCH_CONCURRENCY_API void UnlockShared();
+
+    /// True if a writer holds or waits for the lock
+    CRUNCH_CONCURRENCY_API bool IsWriterActive() const;
+
+    Shared& GetShared()
+    {
+        return mShared;
+    }
+
+    CRUNCH_CONCURRENCY_API CRUNCH_MUST_CHECK_RESULT virtual bool AddWaiter(Waiter* waiter) CRUNCH_OVERRIDE;
+    CRUNCH_CONCURRENCY_API CRUNCH_MUST_CHECK_RESULT virtual bool RemoveWaiter(Waiter* waiter) CRUNCH_OVERRIDE;
+    CRUNCH_CONCURRENCY_API virtual bool IsOrderDependent() const CRUNCH_OVERRIDE;
+
+private:
+    static std::uint32_t const READER_SLOT_COUNT = 32;
+
+    // Set from when a writer takes the write side until it releases it. Waiting writers are kept in the same list.
+    static std::uint64_t const WRITER_BIT = Detail::WaiterList::USER_FLAG_BIT;
+
+    // Set while readers have to queue up for the writer
+    static std::uint64_t const READERS_BLOCKED_BIT = Detail::WaiterList::USER_FLAG_BIT;
+
+    Atomic<std::uint32_t>& GetReaderSlot();
+
+    /// Sum of the slots. Individual slots may wrap as readers can leave through a different slot than they entered.
+    std::uint32_t GetReaderCount() const;
+
+    bool AddSharedWaiter(Waiter* waiter);
+
+    /// Write side is held. Wait for readers to leave.
+    /// \return true if waiter will be notified once they have, false if there are none
+    bool WaitForReaders(Waiter* waiter);
+
+    /// Notify writer waiting for readers if the last one has left
+    void NotifyIfDrained();
+
+    Detail::CacheLineAligned<Atomic<std::uint32_t>> mReaderSlots[READER_SLOT_COUNT];
+
+    Detail::WaiterList mWriters;
+    Detail::WaiterList mReaders;
+
+    // Writer waiting for readers to leave. Tagged so a late reader can't notify a later writer.
+    Detail::WaiterList mDrainWaiter;
+
+    Shared mShared;
+};
+
+}}
+
+#endif
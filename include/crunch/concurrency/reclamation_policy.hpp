@@ -0,0 +1,110 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#ifndef CRUNCH_CONCURRENCY_RECLAMATION_POLICY_HPP
+#define CRUNCH_CONCURRENCY_RECLAMATION_POLICY_HPP
+
+#include "crunch/base/noncopyable.hpp"
+#include "crunch/concurrency/atomic.hpp"
+#include "crunch/concurrency/epoch.hpp"
+#include "crunch/concurrency/hazard_pointer.hpp"
+
+namespace Crunch { namespace Concurrency {
+
+/// Reclamation policies decide when a node removed from a lock-free container may be freed.
+/// A policy provides a Guard that is held for the duration of an operation that dereferences shared nodes:
+///     Guard::Protect(T* node, Atomic<V> const& source, V& sourceValue)
+/// Called with node extracted from sourceValue, returns true if node may be dereferenced. Otherwise updates
+/// sourceValue with the current value of source and the caller must retry.
+
+/// Nodes are type stable, i.e., never freed while the container is in use, typically by recycling them through a
+/// free list. Reading a node after it has been popped by another thread yields stale data that is rejected by ABA
+/// tagging.
+struct ReclamationPolicyNone
+{
+    struct Guard : NonCopyable
+    {
+        template<typename T, typename V>
+        bool Protect(T*, Atomic<V> const&, V&)
+        {
+            return true;
+        }
+    };
+};
+
+/// As ReclamationPolicyNone, but nodes may be returned to an allocator that never unmaps memory. Stale reads of
+/// freed nodes are tolerated as for ReclamationPolicyNone. There is no portable way to trap reads of unmapped memory,
+/// so this relies on the allocator rather than a fault handler.
+struct ReclamationPolicyAccessViolationChecked : ReclamationPolicyNone
+{
+};
+
+/// Popped nodes may be freed through Retire, which defers reclamation until no concurrent Pop can dereference them
+struct ReclamationPolicyHazardPointer
+{
+    struct Guard : NonCopyable
+    {
+        template<typename T, typename V>
+        bool Protect(T* node, Atomic<V> const& source, V& sourceValue)
+        {
+            mHazard.Set(node);
+
+            // Node can't have been reclaimed if it is still reachable after publishing the hazard
+            V const current = source.Load(MEMORY_ORDER_ACQUIRE);
+            if (current == sourceValue)
+                return true;
+
+            sourceValue = current;
+            return false;
+        }
+
+    private:
+        HazardPointer mHazard;
+    };
+
+    /// Delete node once no concurrent operation can access it
+    template<typename T>
+    static void Retire(T* node)
+    {
+        HazardPointer::Retire(node);
+    }
+
+    static void Retire(void* node, void (*reclaim)(void*))
+    {
+        HazardPointer::Retire(node, reclaim);
+    }
+};
+
+/// Popped nodes may be freed through Retire, which defers reclamation until every Pop in progress has completed.
+/// Cheaper than hazard pointers per operation, but a thread stalled in Pop delays all reclamation.
+struct ReclamationPolicyEpoch
+{
+    struct Guard : NonCopyable
+    {
+        template<typename T, typename V>
+        bool Protect(T*, Atomic<V> const&, V&)
+        {
+            // Everything reachable on entry to the critical region stays valid until it is left
+            return true;
+        }
+
+    private:
+        Epoch::Guard mGuard;
+    };
+
+    /// Delete node once no concurrent operation can access it
+    template<typename T>
+    static void Retire(T* node)
+    {
+        Epoch::Retire(node);
+    }
+
+    static void Retire(void* node, void (*reclaim)(void*))
+    {
+        Epoch::Retire(node, reclaim);
+    }
+};
+
+}}
+
+#endif
@@ -55,8 +55,12 @@ struct CRUNCH_NOVTABLE ISchedulerContext
 struct IScheduler
 {
     virtual bool CanOrphan() = 0;
-    // Should be Acquire + Release Context
+
+    /// Get context for the calling thread. Pair with ReleaseContext once the thread is done running it.
     virtual ISchedulerContext& GetContext() = 0;
+
+    /// Give up a context from GetContext, so that it can be reused once its thread is gone
+    virtual void ReleaseContext(ISchedulerContext& context) = 0;
 };
 
 }}
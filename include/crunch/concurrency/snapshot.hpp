@@ -0,0 +1,81 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#ifndef CRUNCH_CONCURRENCY_SNAPSHOT_HPP
+#define CRUNCH_CONCURRENCY_SNAPSHOT_HPP
+
+#include "crunch/base/assert.hpp"
+#include "crunch/base/noncopyable.hpp"
+#include "crunch/concurrency/atomic.hpp"
+#include "crunch/concurrency/grace_period.hpp"
+#include "crunch/concurrency/detail/system_mutex.hpp"
+
+namespace Crunch { namespace Concurrency {
+
+/// Read-copy-update container for read-mostly data of any type, e.g., configuration.
+/// Versions are immutable once published. Readers get a pointer to the current version with a single load and no
+/// shared writes, and may use it until the thread next reports a quiescent state or goes offline, see GracePeriod.
+/// Replaced versions are destroyed once their grace period has elapsed. Unlike VersionedData, T need not be trivially
+/// copyable, and readers never copy it.
+///
+/// Only threads registered with GracePeriod::Reader, which includes MetaScheduler threads while they run, may call
+/// Get().
+template<typename T>
+class Snapshot : NonCopyable
+{
+public:
+    Snapshot()
+        : mCurrent(new T(), MEMORY_ORDER_RELAXED)
+    {}
+
+    explicit Snapshot(T const& initial)
+        : mCurrent(new T(initial), MEMORY_ORDER_RELAXED)
+    {}
+
+    /// Takes ownership of initial
+    explicit Snapshot(T* initial)
+        : mCurrent(initial, MEMORY_ORDER_RELAXED)
+    {
+        CRUNCH_ASSERT(initial != nullptr);
+    }
+
+    /// No readers may be using the current version
+    ~Snapshot()
+    {
+        delete mCurrent.Load(MEMORY_ORDER_ACQUIRE);
+    }
+
+    /// Current version. Valid until the calling thread next reports a quiescent state.
+    T const* Get() const
+    {
+        return mCurrent.Load(MEMORY_ORDER_ACQUIRE);
+    }
+
+    /// Replace the current version. Takes ownership of version.
+    void Publish(T* version)
+    {
+        CRUNCH_ASSERT(version != nullptr);
+        Detail::SystemMutex::ScopedLock const lock(mUpdateLock);
+        GracePeriod::Retire(mCurrent.Swap(version));
+    }
+
+    /// Publish a copy of the current version modified by f
+    template<typename F>
+    void Update(F f)
+    {
+        Detail::SystemMutex::ScopedLock const lock(mUpdateLock);
+
+        // Only writers replace the version, so the writer holding the lock can read it directly
+        T* const version = new T(*mCurrent.Load(MEMORY_ORDER_RELAXED));
+        f(*version);
+        GracePeriod::Retire(mCurrent.Swap(version));
+    }
+
+private:
+    Atomic<T*> mCurrent;
+    Detail::SystemMutex mUpdateLock;
+};
+
+}}
+
+#endif
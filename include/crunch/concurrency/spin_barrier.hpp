@@ -6,6 +6,7 @@
 
 #include "crunch/base/noncopyable.hpp"
 #include "crunch/concurrency/atomic.hpp"
+#include "crunch/concurrency/yield.hpp"
 
 #include <cstdint>
 
@@ -0,0 +1,205 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#ifndef CRUNCH_CONCURRENCY_SPSC_BOUNDED_QUEUE_HPP
+#define CRUNCH_CONCURRENCY_SPSC_BOUNDED_QUEUE_HPP
+
+#include "crunch/base/noncopyable.hpp"
+#include "crunch/concurrency/atomic.hpp"
+#include "crunch/concurrency/waitable.hpp"
+#include "crunch/concurrency/detail/cache_line.hpp"
+#include "crunch/concurrency/detail/condition_waitable.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace Crunch { namespace Concurrency {
+
+/// Bounded single-producer single-consumer FIFO queue on a ring buffer. Wait free.
+/// The producer and consumer each own a cache line holding their position and a cached copy of the other side's
+/// position, so the shared lines are only read when the cached copy says the queue looks full or empty.
+/// The batch variants publish any number of items with a single release store.
+///
+/// GetNotEmptyCondition lets the consumer WaitFor items. Supporting it costs the producer a full fence per publish,
+/// which the batch variants amortise. The move constructor of T must not throw.
+template<typename T>
+class SPSCBoundedQueue : NonCopyable
+{
+public:
+    /// \param capacityLog2 Log2 of the maximum number of items in the queue
+    SPSCBoundedQueue(std::uint32_t capacityLog2)
+        : mMask((std::size_t(1) << capacityLog2) - 1)
+        , mStorage(new StorageType[mMask + 1])
+        , mNotEmpty(&SPSCBoundedQueue::IsNotEmpty, this)
+    {
+        mProducer.value.cachedHead = 0;
+        mConsumer.value.cachedTail = 0;
+        mConsumer.value.head.Store(0, MEMORY_ORDER_RELAXED);
+        mProducer.value.tail.Store(0, MEMORY_ORDER_RELEASE);
+    }
+
+    ~SPSCBoundedQueue()
+    {
+        std::size_t const end = mProducer.value.tail.Load(MEMORY_ORDER_ACQUIRE);
+        for (std::size_t position = mConsumer.value.head.Load(MEMORY_ORDER_ACQUIRE); position != end; ++position)
+            At(position).~T();
+
+        delete [] mStorage;
+    }
+
+    std::size_t GetCapacity() const
+    {
+        return mMask + 1;
+    }
+
+    /// Consumer side view. May be stale by the time it returns when called by the producer.
+    bool IsEmpty() const
+    {
+        return mConsumer.value.head.Load(MEMORY_ORDER_RELAXED) == mProducer.value.tail.Load(MEMORY_ORDER_ACQUIRE);
+    }
+
+    /// Ready when there are items to pop. Only the consumer may wait on it.
+    IWaitable& GetNotEmptyCondition()
+    {
+        return mNotEmpty;
+    }
+
+    /// Producer only
+    /// \return false if full
+    template<typename TT>
+    bool TryPush(TT&& value)
+    {
+        std::size_t const tail = mProducer.value.tail.Load(MEMORY_ORDER_RELAXED);
+        if (GetFreeCount(tail, 1) == 0)
+            return false;
+
+        ::new (&mStorage[tail & mMask]) T(std::forward<TT>(value));
+        Publish(tail + 1);
+        return true;
+    }
+
+    /// Producer only. Pushes as many items from [first, last) as there is room for.
+    /// \return Iterator to the first item not pushed
+    template<typename InputIterator>
+    InputIterator PushBatch(InputIterator first, InputIterator last)
+    {
+        std::size_t const tail = mProducer.value.tail.Load(MEMORY_ORDER_RELAXED);
+        std::size_t const freeCount = GetFreeCount(tail, mMask + 1);
+
+        std::size_t position = tail;
+        for (; first != last && position - tail != freeCount; ++first, ++position)
+            ::new (&mStorage[position & mMask]) T(*first);
+
+        if (position != tail)
+            Publish(position);
+
+        return first;
+    }
+
+    /// Consumer only
+    /// \return false if empty
+    bool TryPop(T& outValue)
+    {
+        std::size_t const head = mConsumer.value.head.Load(MEMORY_ORDER_RELAXED);
+        if (GetAvailableCount(head, 1) == 0)
+            return false;
+
+        T& value = At(head);
+        outValue = std::move(value);
+        value.~T();
+
+        mConsumer.value.head.Store(head + 1, MEMORY_ORDER_RELEASE);
+        return true;
+    }
+
+    /// Consumer only. Pops up to maxCount items into out and frees their cells with a single store.
+    /// \return Number of items popped
+    template<typename OutputIterator>
+    std::size_t PopBatch(OutputIterator out, std::size_t maxCount)
+    {
+        std::size_t const head = mConsumer.value.head.Load(MEMORY_ORDER_RELAXED);
+        std::size_t const count = GetAvailableCount(head, maxCount);
+
+        for (std::size_t position = head; position != head + count; ++position)
+        {
+            T& value = At(position);
+            *out++ = std::move(value);
+            value.~T();
+        }
+
+        if (count != 0)
+            mConsumer.value.head.Store(head + count, MEMORY_ORDER_RELEASE);
+
+        return count;
+    }
+
+private:
+    typedef typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type StorageType;
+
+    struct ProducerState
+    {
+        Atomic<std::size_t> tail;
+        std::size_t cachedHead;
+    };
+
+    struct ConsumerState
+    {
+        Atomic<std::size_t> head;
+        std::size_t cachedTail;
+    };
+
+    T& At(std::size_t position)
+    {
+        return reinterpret_cast<T&>(mStorage[position & mMask]);
+    }
+
+    /// Free cells from tail, refreshing the cached head only if fewer than wanted appear free
+    std::size_t GetFreeCount(std::size_t tail, std::size_t wanted)
+    {
+        std::size_t const capacity = mMask + 1;
+        std::size_t freeCount = capacity - (tail - mProducer.value.cachedHead);
+        if (freeCount < wanted)
+        {
+            mProducer.value.cachedHead = mConsumer.value.head.Load(MEMORY_ORDER_ACQUIRE);
+            freeCount = capacity - (tail - mProducer.value.cachedHead);
+        }
+        return freeCount;
+    }
+
+    /// Items available from head, refreshing the cached tail only if fewer than wanted appear available
+    std::size_t GetAvailableCount(std::size_t head, std::size_t wanted)
+    {
+        std::size_t available = mConsumer.value.cachedTail - head;
+        if (available < wanted)
+        {
+            mConsumer.value.cachedTail = mProducer.value.tail.Load(MEMORY_ORDER_ACQUIRE);
+            available = mConsumer.value.cachedTail - head;
+        }
+        return available < wanted ? available : wanted;
+    }
+
+    void Publish(std::size_t tail)
+    {
+        mProducer.value.tail.Store(tail, MEMORY_ORDER_RELEASE);
+        mNotEmpty.Notify();
+    }
+
+    static bool IsNotEmpty(void const* context)
+    {
+        return !static_cast<SPSCBoundedQueue const*>(context)->IsEmpty();
+    }
+
+    std::size_t const mMask;
+    StorageType* const mStorage;
+    Detail::ConditionWaitable mNotEmpty;
+
+    Detail::CacheLineAligned<ProducerState> mProducer;
+    Detail::CacheLineAligned<ConsumerState> mConsumer;
+};
+
+}}
+
+#endif
@@ -0,0 +1,109 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#ifndef CRUNCH_CONCURRENCY_TAGGED_POINTER_HPP
+#define CRUNCH_CONCURRENCY_TAGGED_POINTER_HPP
+
+#include "crunch/base/align.hpp"
+#include "crunch/base/assert.hpp"
+#include "crunch/base/platform.hpp"
+
+#include <cstdint>
+
+namespace Crunch { namespace Concurrency {
+
+/// Pointer with a pointer sized ABA tag, for use with Atomic. Twice the pointer size, so updates use a double width
+/// compare and swap, i.e., cmpxchg16b on x86-64 and cmpxchg8b on x86.
+template<typename T>
+struct CRUNCH_ALIGN_PREFIX(CRUNCH_PTR_SIZE * 2) TaggedPointer
+{
+    T* pointer;
+    std::uintptr_t tag;
+
+    bool operator == (TaggedPointer const& rhs) const
+    {
+        return pointer == rhs.pointer && tag == rhs.tag;
+    }
+
+    bool operator != (TaggedPointer const& rhs) const
+    {
+        return !(*this == rhs);
+    }
+} CRUNCH_ALIGN_POSTFIX(CRUNCH_PTR_SIZE * 2);
+
+/// Tagged pointer representations for lock-free containers.
+/// Policy::Root<T> provides
+///     typedef ValueType
+///     static ValueType Null()
+///     static T* GetPointer(ValueType)
+///     static ValueType Replace(ValueType old, T* pointer)    -- new value with pointer and old tag advanced
+
+/// 48 bit pointer and 16 bit tag packed in a 64 bit word on 64-bit platforms. Assumes a 48 bit address space, and
+/// the tag wraps after 65536 updates. On 32-bit platforms the pointer and tag are 32 bits each.
+struct PackedTaggedPointerPolicy
+{
+    template<typename T>
+    struct Root
+    {
+        typedef std::uint64_t ValueType;
+
+#if (CRUNCH_PTR_SIZE == 4)
+        static std::uint64_t const PTR_MASK   = 0x00000000ffffffffull;
+        static std::uint64_t const ABA_MASK   = 0xffffffff00000000ull;
+        static std::uint64_t const ABA_ADDEND = 0x0000000100000000ull;
+#else
+        // Assume 48 bit address space
+        static std::uint64_t const PTR_MASK   = 0x0000ffffffffffffull;
+        static std::uint64_t const ABA_MASK   = 0xffff000000000000ull;
+        static std::uint64_t const ABA_ADDEND = 0x0001000000000000ull;
+#endif
+
+        static ValueType Null()
+        {
+            return 0;
+        }
+
+        static T* GetPointer(ValueType value)
+        {
+            return reinterpret_cast<T*>(value & PTR_MASK);
+        }
+
+        static ValueType Replace(ValueType old, T* pointer)
+        {
+            CRUNCH_ASSERT((reinterpret_cast<std::uint64_t>(pointer) & ~PTR_MASK) == 0);
+            return reinterpret_cast<std::uint64_t>(pointer) + (old & ABA_MASK) + ABA_ADDEND;
+        }
+    };
+};
+
+/// Full pointer and pointer sized tag updated with double width compare and swap. No address space assumptions,
+/// and the tag doesn't wrap in practice.
+struct DoubleWidthTaggedPointerPolicy
+{
+    template<typename T>
+    struct Root
+    {
+        typedef TaggedPointer<T> ValueType;
+
+        static ValueType Null()
+        {
+            ValueType const value = { nullptr, 0 };
+            return value;
+        }
+
+        static T* GetPointer(ValueType value)
+        {
+            return value.pointer;
+        }
+
+        static ValueType Replace(ValueType old, T* pointer)
+        {
+            ValueType const value = { pointer, old.tag + 1 };
+            return value;
+        }
+    };
+};
+
+}}
+
+#endif
@@ -0,0 +1,137 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#ifndef CRUNCH_CONCURRENCY_TASK_SCHEDULER_HPP
+#define CRUNCH_CONCURRENCY_TASK_SCHEDULER_HPP
+
+#include "crunch/base/noncopyable.hpp"
+#include "crunch/base/override.hpp"
+#include "crunch/base/result_of.hpp"
+#include "crunch/concurrency/api.hpp"
+#include "crunch/concurrency/atomic.hpp"
+#include "crunch/concurrency/event.hpp"
+#include "crunch/concurrency/future.hpp"
+#include "crunch/concurrency/promise.hpp"
+#include "crunch/concurrency/scheduler.hpp"
+#include "crunch/concurrency/thread_local.hpp"
+#include "crunch/concurrency/detail/system_mutex.hpp"
+
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <vector>
+
+namespace Crunch { namespace Concurrency {
+
+/// Work stealing task scheduler for use with MetaScheduler.
+/// Each thread running the scheduler gets its own context with a work stealing deque. Tasks posted from a thread
+/// running a context go on that context's deque, other tasks are injected through a shared queue. Idle contexts
+/// steal from random victims before going idle, and the has work condition is only touched on idle transitions.
+class TaskScheduler : public IScheduler, NonCopyable
+{
+public:
+    /// \param maxContextCount Maximum number of threads that may hold a context at the same time
+    CRUNCH_CONCURRENCY_API TaskScheduler(std::uint32_t maxContextCount = 64);
+    CRUNCH_CONCURRENCY_API ~TaskScheduler();
+
+    template<typename F>
+    Future<typename ResultOf<F>::Type> Post(F f);
+
+    CRUNCH_CONCURRENCY_API virtual bool CanOrphan() CRUNCH_OVERRIDE;
+
+    /// Get context for the calling thread. Reuses a released context, or creates one if there is none.
+    CRUNCH_CONCURRENCY_API virtual ISchedulerContext& GetContext() CRUNCH_OVERRIDE;
+
+    /// Tasks left on a released context stay available to thieves, and to the next thread that takes it over
+    CRUNCH_CONCURRENCY_API virtual void ReleaseContext(ISchedulerContext& context) CRUNCH_OVERRIDE;
+
+private:
+    struct Task : NonCopyable
+    {
+        virtual void Run() = 0;
+        virtual ~Task() {}
+    };
+
+    template<typename F, typename R> struct TypedTask;
+
+    class ContextImpl;
+    typedef std::unique_ptr<ContextImpl> ContextPtr;
+
+    CRUNCH_CONCURRENCY_API void AddTask(Task* task);
+
+    Task* PopInjected();
+
+    std::uint32_t const mMaxContextCount;
+
+    // Reserved up front so stealing threads can index without locking
+    Detail::SystemMutex mContextsLock;
+    std::vector<ContextPtr> mContexts;
+    Atomic<std::uint32_t> mContextCount;
+
+    Detail::SystemMutex mInjectedLock;
+    std::deque<Task*> mInjected;
+    Atomic<std::uint32_t> mInjectedCount;
+
+    Atomic<std::uint32_t> mIdleContextCount;
+    Event mHasWork;
+
+    // Context currently running on this thread, if any
+    static CRUNCH_THREAD_LOCAL ContextImpl* tCurrentContext;
+};
+
+template<typename F, typename R>
+struct TaskScheduler::TypedTask : Task
+{
+    TypedTask(F&& f) : f(std::move(f)) {}
+
+    virtual void Run() CRUNCH_OVERRIDE
+    {
+        try
+        {
+            promise.SetValue(f());
+        }
+        catch (...)
+        {
+            promise.SetException(std::current_exception());
+        }
+    }
+
+    Promise<R> promise;
+    F f;
+};
+
+template<typename F>
+struct TaskScheduler::TypedTask<F, void> : Task
+{
+    TypedTask(F&& f) : f(std::move(f)) {}
+
+    virtual void Run() CRUNCH_OVERRIDE
+    {
+        try
+        {
+            f();
+            promise.SetValue();
+        }
+        catch (...)
+        {
+            promise.SetException(std::current_exception());
+        }
+    }
+
+    Promise<void> promise;
+    F f;
+};
+
+template<typename F>
+Future<typename ResultOf<F>::Type> TaskScheduler::Post(F f)
+{
+    auto task = new TypedTask<F, typename ResultOf<F>::Type>(std::move(f));
+    auto future = task->promise.GetFuture();
+    AddTask(task);
+    return future;
+}
+
+}}
+
+#endif
@@ -7,23 +7,45 @@
 #include "crunch/base/noncopyable.hpp"
 #include "crunch/base/result_of.hpp"
 #include "crunch/concurrency/api.hpp"
+#include "crunch/concurrency/atomic.hpp"
 #include "crunch/concurrency/future.hpp"
-#include "crunch/concurrency/promise.hpp"
 #include "crunch/concurrency/thread.hpp"
+#include "crunch/concurrency/thread_local.hpp"
+#include "crunch/concurrency/detail/future_data.hpp"
 #include "crunch/concurrency/detail/system_condition.hpp"
 #include "crunch/concurrency/detail/system_mutex.hpp"
 
+#include <cstddef>
 #include <cstdint>
-#include <deque>
+#include <exception>
+#include <memory>
+#include <new>
+#include <type_traits>
 #include <vector>
 
 namespace Crunch { namespace Concurrency {
 
-/// Very simple thread pool for coarse grained tasks. Not designed for performance.
+namespace Detail
+{
+    /// Return the work item slots cached by the calling thread to the shared pool. Called on thread exit.
+    CRUNCH_CONCURRENCY_API void ReleaseWorkItemSlotCache();
+}
+
+/// Thread pool with two modes of operation.
+/// MODE_SIMPLE: Very simple thread pool for coarse grained tasks. Not designed for performance.
+/// MODE_HIGH_THROUGHPUT: For fine grained tasks. Each thread has its own lock-free queue and steals from other
+///                       threads when out of work. Idle threads spin before parking.
 class ThreadPool : NonCopyable
 {
 public:
-    CRUNCH_CONCURRENCY_API ThreadPool(std::uint32_t maxThreadCount);
+    enum Mode
+    {
+        MODE_SIMPLE,         ///< Threads spawned on demand, single locked queue
+        MODE_HIGH_THROUGHPUT ///< All threads spawned up front, per thread lock-free queues with work stealing
+    };
+
+    /// maxThreadCount must be non-zero in MODE_HIGH_THROUGHPUT
+    CRUNCH_CONCURRENCY_API ThreadPool(std::uint32_t maxThreadCount, Mode mode = MODE_SIMPLE);
     CRUNCH_CONCURRENCY_API ~ThreadPool();
 
     template<typename F>
@@ -33,12 +55,39 @@ public:
 
 private:
     template<typename F, typename R> struct Runner;
+    template<typename F, typename R> class Task;
+
+    /// Intrusive work item, queued without further allocation
+    struct WorkItem
+    {
+        WorkItem* next;
+        void (*run)(WorkItem*);
+    };
+
+    struct Worker;
+    typedef std::unique_ptr<Worker> WorkerPtr;
+
+    /// Tasks that fit in a slot are allocated from a recycled pool, larger ones from the heap
+    static std::size_t const WORK_ITEM_SLOT_SIZE = 128;
+    static std::size_t const WORK_ITEM_SLOT_ALIGNMENT = 16;
+
+    CRUNCH_CONCURRENCY_API static void* AllocateSlot();
+    CRUNCH_CONCURRENCY_API static void FreeSlot(void* slot);
 
-    typedef std::function<void ()> WorkItem;
+    CRUNCH_CONCURRENCY_API void AddWorkItem(WorkItem* work);
 
-    CRUNCH_CONCURRENCY_API void AddWorkItem(WorkItem&& work);
+    void AddWorkItemSimple(WorkItem* work);
+    void AddWorkItemHighThroughput(WorkItem* work);
+
+    void RunWorker(Worker& worker);
+    WorkItem* FindWork(Worker& worker);
+    bool HasWork() const;
+    void Park(Worker& worker);
+    bool Wake(Worker& worker);
+    void WakeOne();
 
     std::uint32_t const mMaxThreadCount;
+    Mode const mMode;
 
     mutable Detail::SystemMutex mLock;
     volatile bool mStop;
@@ -46,52 +95,114 @@ private:
     std::vector<Thread> mThreads;
     std::uint32_t mIdleThreadCount;
 
-    std::deque<WorkItem> mWork;
+    WorkItem* mWorkHead;
+    WorkItem* mWorkTail;
     Detail::SystemCondition mHasWork;
+
+    // MODE_HIGH_THROUGHPUT state
+    std::vector<WorkerPtr> mWorkers;
+    Atomic<std::uint32_t> mNextWorker;
+    Atomic<std::uint32_t> mSleepingCount;
+
+    static CRUNCH_THREAD_LOCAL Worker* tCurrentWorker;
 };
 
 template<typename F, typename R>
 struct ThreadPool::Runner
 {
-    Runner(Promise<R>* p, F f) : p(p), f(f) {}
+    Runner(F&& f) : f(std::move(f)) {}
 
-    void operator ()() const
+    void operator ()(Detail::FutureData<R>& result)
     {
-        p->SetValue(f());
-        delete p;
+        result.Set(f());
     }
 
-    Promise<R>* p;
     F f;
 };
 
 template<typename F>
 struct ThreadPool::Runner<F, void>
 {
-    Runner(Promise<void>* p, F f) : p(p), f(f) {}
+    Runner(F&& f) : f(std::move(f)) {}
 
-    void operator ()() const
+    void operator ()(Detail::FutureData<void>& result)
     {
         f();
-        p->SetValue();
-        delete p;
+        result.Set();
     }
 
-    Promise<void>* p;
     F f;
 };
 
+/// Future data and work item in a single allocation. Holds one reference on behalf of the queue until run.
+template<typename F, typename R>
+class ThreadPool::Task : public Detail::FutureData<R>, public WorkItem
+{
+public:
+    static Task* Create(F&& f)
+    {
+        void* const memory = IsPooled() ? AllocateSlot() : ::operator new(sizeof(Task));
+        return ::new (memory) Task(std::move(f));
+    }
+
+private:
+    static bool IsPooled()
+    {
+        return
+            sizeof(Task) <= WORK_ITEM_SLOT_SIZE &&
+            std::alignment_of<Task>::value <= WORK_ITEM_SLOT_ALIGNMENT;
+    }
+
+    Task(F&& f)
+        : Detail::FutureData<R>(1)
+        , mRunner(std::move(f))
+    {
+        this->next = nullptr;
+        this->run = &Task::Run;
+    }
+
+    static void Run(WorkItem* item)
+    {
+        Task* const task = static_cast<Task*>(item);
+
+        try
+        {
+            task->mRunner(*task);
+        }
+        catch (...)
+        {
+            task->SetException(std::current_exception());
+        }
+
+        Detail::Release(task);
+    }
+
+    virtual void Destroy() CRUNCH_OVERRIDE
+    {
+        this->~Task();
+
+        if (IsPooled())
+            FreeSlot(this);
+        else
+            ::operator delete(this);
+    }
+
+    Runner<F, R> mRunner;
+};
+
 template<typename F>
 Future<typename ResultOf<F>::Type> ThreadPool::Post(F f)
 {
-    // Would like to move promise, but can't capture in lambda by move
-    auto promise = new Promise<typename ResultOf<F>::Type>();
-    auto future = promise->GetFuture();
-    AddWorkItem(Runner<F, typename ResultOf<F>::Type>(promise, f));
-    return future;
-}
+    typedef typename ResultOf<F>::Type ResultType;
+    typedef Task<F, ResultType> TaskType;
 
+    TaskType* const task = TaskType::Create(std::move(f));
 
+    // Take future reference before queuing, as the task may complete and release its reference immediately
+    Future<ResultType> future((typename Future<ResultType>::DataPtr(task)));
+    AddWorkItem(task);
+    return future;
+}
 
 }}
 
@@ -0,0 +1,63 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#ifndef CRUNCH_CONCURRENCY_TREE_BARRIER_HPP
+#define CRUNCH_CONCURRENCY_TREE_BARRIER_HPP
+
+#include "crunch/base/noncopyable.hpp"
+#include "crunch/concurrency/api.hpp"
+#include "crunch/concurrency/atomic.hpp"
+#include "crunch/concurrency/processor_topology.hpp"
+#include "crunch/concurrency/detail/cache_line.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace Crunch { namespace Concurrency {
+
+/// Reusable combining tree barrier laid out after the processor topology.
+/// Participants arrive at a counter shared with the others on their core, the last of them at a counter for the
+/// package, and the last of those at the root. Most arrivals therefore only touch cache lines within a core or package.
+/// The last participant at the root releases everyone through a phase word that waiters spin on and then sleep on.
+///
+/// Participant indices map to processors ordered by package, core and thread, so participant i should run on
+/// GetProcessor(i), e.g., by setting its affinity. With more participants than processors the mapping wraps around.
+class TreeBarrier : NonCopyable
+{
+public:
+    /// \param spinCount Number of times Wait checks for phase completion before going to sleep
+    CRUNCH_CONCURRENCY_API TreeBarrier(ProcessorTopology const& topology, std::uint32_t participantCount, std::uint32_t spinCount = 1000);
+    CRUNCH_CONCURRENCY_API ~TreeBarrier();
+
+    /// Processor participant is laid out for
+    ProcessorTopology::Processor const& GetProcessor(std::uint32_t participant) const
+    {
+        return mProcessors[participant];
+    }
+
+    /// Arrive and wait for the remaining participants
+    /// \return true for the one participant that completed the phase
+    CRUNCH_CONCURRENCY_API bool Wait(std::uint32_t participant);
+
+private:
+    struct Node
+    {
+        Atomic<std::uint32_t> remaining;
+        std::uint32_t count;
+        Node* parent;
+    };
+
+    typedef Detail::CacheLineAligned<Node> AlignedNode;
+
+    Node* AddNode(std::uint32_t count);
+
+    std::uint32_t const mSpinCount;
+    std::vector<AlignedNode*> mNodes;
+    std::vector<Node*> mLeaves;
+    ProcessorTopology::ProcessorList mProcessors;
+    Detail::CacheLineAligned<Atomic<std::uint32_t>> mPhase;
+};
+
+}}
+
+#endif
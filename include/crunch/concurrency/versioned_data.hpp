@@ -4,9 +4,14 @@
 #ifndef CRUNCH_CONCURRENCY_VERSIONED_DATA_HPP
 #define CRUNCH_CONCURRENCY_VERSIONED_DATA_HPP
 
+#include "crunch/concurrency/atomic.hpp"
+#include "crunch/concurrency/fence.hpp"
+#include "crunch/concurrency/yield.hpp"
 #include "crunch/concurrency/detail/system_mutex.hpp"
 
 #include <cstdint>
+#include <cstring>
+#include <type_traits>
 
 namespace Crunch { namespace Concurrency {
 
@@ -48,6 +53,82 @@ private:
     T mData;
 };
 
+/// As VersionedData, but readers never write shared state. Readers copy the data optimistically and retry if the
+/// sequence number shows a concurrent update, so any number of readers scale as long as updates are rare. Updates
+/// are serialized by a mutex that readers never take. Readers see a copy, so T must be trivially copyable and should
+/// be small. Versions wrap at 2^31.
+///
+/// Reference: Lameter. Effective synchronization on Linux/NUMA systems. 2005.
+template<typename T>
+class SeqLockVersionedData
+{
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLockVersionedData requires trivially copyable data");
+
+public:
+    SeqLockVersionedData(std::uint32_t initialVersion = 0)
+        : mSequence(initialVersion << 1, MEMORY_ORDER_RELAXED)
+        , mData()
+    {}
+
+    bool HasChanged(std::uint32_t lastSeenVersion) const
+    {
+        return lastSeenVersion != (mSequence.Load(MEMORY_ORDER_ACQUIRE) >> 1);
+    }
+
+    template<typename F>
+    void Update(F f)
+    {
+        Detail::SystemMutex::ScopedLock const lock(mWriteLock);
+
+        // Only writers modify the data, so the writer holding the lock can read it directly
+        T data = mData;
+        f(data);
+
+        // Odd sequence marks the update in progress. The fence publishes it before the data, and the release store
+        // publishes the data before the final sequence.
+        std::uint32_t const sequence = mSequence.Load(MEMORY_ORDER_RELAXED);
+        mSequence.Store(sequence + 1, MEMORY_ORDER_RELAXED);
+        CRUNCH_RELEASE_FENCE();
+        std::memcpy(&mData, &data, sizeof(T));
+        mSequence.Store(sequence + 2, MEMORY_ORDER_RELEASE);
+    }
+
+    template<typename F>
+    void ReadIfDifferent(std::uint32_t& localVersion, F f) const
+    {
+        for (;;)
+        {
+            std::uint32_t const sequence = mSequence.Load(MEMORY_ORDER_ACQUIRE);
+            if ((sequence >> 1) == localVersion)
+                return;
+
+            if (sequence & 1)
+            {
+                CRUNCH_PAUSE();
+                continue;
+            }
+
+            // Copy may be torn by a concurrent update, in which case the sequence will have moved on. The fence keeps
+            // the data reads ahead of the sequence check.
+            T data;
+            std::memcpy(&data, &mData, sizeof(T));
+            CRUNCH_ACQUIRE_FENCE();
+
+            if (mSequence.Load(MEMORY_ORDER_ACQUIRE) == sequence)
+            {
+                localVersion = sequence >> 1;
+                f(data);
+                return;
+            }
+        }
+    }
+
+private:
+    mutable Detail::SystemMutex mWriteLock;
+    Atomic<std::uint32_t> mSequence;
+    T mData;
+};
+
 }}
 
 #endif
@@ -4,15 +4,18 @@
 #ifndef CRUNCH_CONCURRENCY_WAIT_MODE_HPP
 #define CRUNCH_CONCURRENCY_WAIT_MODE_HPP
 
+#include "crunch/base/duration.hpp"
+
 #include <cstdint>
 
 namespace Crunch { namespace Concurrency {
 
 struct WaitMode
 {
-    WaitMode(std::uint32_t spinCount, bool runCooperative)
+    WaitMode(std::uint32_t spinCount, bool runCooperative, Duration timeout = Duration::PosInfinity)
         : spinCount(spinCount)
         , runCooperative(runCooperative)
+        , timeout(timeout)
     {}
 
     static WaitMode Poll()
@@ -25,13 +28,24 @@ struct WaitMode
         return WaitMode(spinCount, false);
     }
 
+    /// On MetaScheduler threads, run work from re-entrant schedulers while waiting. Blocks elsewhere, and always blocks
+    /// on order dependent waitables like mutexes. Don't use while holding locks the work might need.
     static WaitMode Run(std::uint32_t spinCount = 0)
     {
         return WaitMode(spinCount, true);
     }
 
+    /// Same mode, but give up once timeout has elapsed
+    WaitMode WithTimeout(Duration timeout) const
+    {
+        return WaitMode(spinCount, runCooperative, timeout);
+    }
+
     std::uint32_t spinCount;
     bool runCooperative;
+
+    /// Time budget for the whole wait. PosInfinity waits indefinitely.
+    Duration timeout;
 };
 
 }}
@@ -45,8 +45,17 @@ struct CRUNCH_CONCURRENCY_API CRUNCH_NOVTABLE IWaitable
 /// List of signaled waitables
 typedef Containers::SmallVector<IWaitable*, 16> WaitForAnyResult;
 
-CRUNCH_CONCURRENCY_API void WaitFor(IWaitable& waitable, WaitMode waitMode = WaitMode::Run());
-CRUNCH_CONCURRENCY_API void WaitForAll(IWaitable** waitables, std::size_t count, WaitMode waitMode = WaitMode::Run());
+// Waits return once notified, or when the timeout of waitMode has elapsed, in which case any waiters still pending
+// are removed again before returning.
+
+/// \return false if timed out
+CRUNCH_CONCURRENCY_API bool WaitFor(IWaitable& waitable, WaitMode waitMode = WaitMode::Run());
+
+/// \return false if timed out. Waitables notified before the timeout stay notified. A finite timeout is only supported
+///         when no waitable is order dependent, since e.g. mutexes acquired before the timeout would remain locked.
+CRUNCH_CONCURRENCY_API bool WaitForAll(IWaitable** waitables, std::size_t count, WaitMode waitMode = WaitMode::Run());
+
+/// \return empty if timed out
 CRUNCH_CONCURRENCY_API WaitForAnyResult WaitForAny(IWaitable** waitables, std::size_t count, WaitMode waitMode = WaitMode::Run());
 
 }}
@@ -23,6 +23,12 @@ public:
     template<typename F>
     static Typed<F>* Create(F callback, bool destroyOnNotify);
 
+    /// Create waiter in caller owned storage of at least sizeof(Waiter) bytes, suitably aligned. The waiter is never
+    /// destroyed on notify and must not be passed to Destroy. Callback must fit inline and be trivially destructible,
+    /// so that a block of waiters can be released at once by releasing the storage.
+    template<typename F>
+    static Typed<F>* CreateInPlace(void* storage, F callback);
+
     void Notify();
 
     Waiter* next;
@@ -74,6 +80,17 @@ Waiter::Typed<F>* Waiter::Create(F callback, bool destroyOnNotify)
     return waiter;
 }
 
+template<typename F>
+Waiter::Typed<F>* Waiter::CreateInPlace(void* storage, F callback)
+{
+    static_assert(sizeof(F) <= sizeof(StorageType), "In place waiter callback must fit inline");
+    static_assert(std::is_trivially_destructible<F>::value, "In place waiter callback must be trivially destructible");
+
+    Waiter::Typed<F>* waiter = new (storage) Waiter::Typed<F>(&Waiter::Typed<F>::Invoke);
+    new (&waiter->mStorage) F(std::move(callback));
+    return waiter;
+}
+
 template<typename F>
 void Waiter::Typed<F>::Destroy()
 {
@@ -0,0 +1,161 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#ifndef CRUNCH_CONCURRENCY_WORK_STEALING_DEQUE_HPP
+#define CRUNCH_CONCURRENCY_WORK_STEALING_DEQUE_HPP
+
+#include "crunch/base/noncopyable.hpp"
+#include "crunch/concurrency/atomic.hpp"
+#include "crunch/concurrency/fence.hpp"
+
+#include <cstdint>
+
+namespace Crunch { namespace Concurrency {
+
+/// Chase-Lev work stealing deque of pointers.
+/// Push and Pop may only be called by the owning thread, and operate LIFO on the bottom end.
+/// Steal may be called by any thread, and operates FIFO on the top end.
+///
+/// Reference: Chase, Lev. Dynamic Circular Work-Stealing Deque. SPAA 2005.
+///            Le, Pop, Cohen, Nardelli. Correct and Efficient Work-Stealing for Weak Memory Models. PPoPP 2013.
+template<typename T>
+class WorkStealingDeque : NonCopyable
+{
+public:
+    WorkStealingDeque(std::uint32_t initialCapacityLog2 = 8)
+        : mTop(0, MEMORY_ORDER_RELAXED)
+        , mBottom(0, MEMORY_ORDER_RELAXED)
+        , mArray(new Array(std::int64_t(1) << initialCapacityLog2, nullptr), MEMORY_ORDER_RELEASE)
+    {}
+
+    ~WorkStealingDeque()
+    {
+        // Arrays replaced by growth may still be read by concurrent stealers, so they're kept until destruction
+        Array* array = mArray.Load(MEMORY_ORDER_RELAXED);
+        while (array)
+        {
+            Array* const previous = array->previous;
+            delete array;
+            array = previous;
+        }
+    }
+
+    /// Owner only
+    void Push(T* item)
+    {
+        std::int64_t const bottom = mBottom.Load(MEMORY_ORDER_RELAXED);
+        std::int64_t const top = mTop.Load(MEMORY_ORDER_ACQUIRE);
+        Array* array = mArray.Load(MEMORY_ORDER_RELAXED);
+
+        if (bottom - top > array->mask)
+            array = Grow(array, top, bottom);
+
+        array->Put(bottom, item);
+        mBottom.Store(bottom + 1, MEMORY_ORDER_RELEASE);
+    }
+
+    /// Owner only
+    /// \return Most recently pushed item, or nullptr if empty
+    T* Pop()
+    {
+        std::int64_t const bottom = mBottom.Load(MEMORY_ORDER_RELAXED) - 1;
+        Array* const array = mArray.Load(MEMORY_ORDER_RELAXED);
+        mBottom.Store(bottom, MEMORY_ORDER_RELAXED);
+
+        // Publish bottom before reading top so a racing Steal of the last item is detected
+        CRUNCH_MEMORY_FENCE();
+
+        std::int64_t top = mTop.Load(MEMORY_ORDER_RELAXED);
+        if (top > bottom)
+        {
+            // Empty
+            mBottom.Store(bottom + 1, MEMORY_ORDER_RELAXED);
+            return nullptr;
+        }
+
+        T* item = array->Get(bottom);
+        if (top == bottom)
+        {
+            // Last item, race against stealers for it
+            if (!mTop.CompareAndSwap(top, top + 1))
+                item = nullptr;
+
+            mBottom.Store(bottom + 1, MEMORY_ORDER_RELAXED);
+        }
+
+        return item;
+    }
+
+    /// Any thread
+    /// \return Least recently pushed item, or nullptr if empty or lost race with another thief or the owner
+    T* Steal()
+    {
+        std::int64_t top = mTop.Load(MEMORY_ORDER_ACQUIRE);
+
+        CRUNCH_MEMORY_FENCE();
+
+        std::int64_t const bottom = mBottom.Load(MEMORY_ORDER_ACQUIRE);
+        if (top >= bottom)
+            return nullptr;
+
+        Array* const array = mArray.Load(MEMORY_ORDER_ACQUIRE);
+        T* const item = array->Get(top);
+        if (!mTop.CompareAndSwap(top, top + 1))
+            return nullptr;
+
+        return item;
+    }
+
+    /// Approximate when called concurrently with other operations
+    bool IsEmpty() const
+    {
+        return mBottom.Load(MEMORY_ORDER_RELAXED) <= mTop.Load(MEMORY_ORDER_RELAXED);
+    }
+
+private:
+    struct Array : NonCopyable
+    {
+        Array(std::int64_t capacity, Array* previous)
+            : mask(capacity - 1)
+            , items(new Atomic<T*>[static_cast<std::size_t>(capacity)])
+            , previous(previous)
+        {}
+
+        ~Array()
+        {
+            delete [] items;
+        }
+
+        T* Get(std::int64_t index) const
+        {
+            return items[index & mask].Load(MEMORY_ORDER_RELAXED);
+        }
+
+        void Put(std::int64_t index, T* item)
+        {
+            items[index & mask].Store(item, MEMORY_ORDER_RELAXED);
+        }
+
+        std::int64_t const mask;
+        Atomic<T*>* const items;
+        Array* const previous;
+    };
+
+    Array* Grow(Array* array, std::int64_t top, std::int64_t bottom)
+    {
+        Array* const grown = new Array((array->mask + 1) * 2, array);
+        for (std::int64_t i = top; i < bottom; ++i)
+            grown->Put(i, array->Get(i));
+
+        mArray.Store(grown, MEMORY_ORDER_RELEASE);
+        return grown;
+    }
+
+    Atomic<std::int64_t> mTop;
+    Atomic<std::int64_t> mBottom;
+    Atomic<Array*> mArray;
+};
+
+}}
+
+#endif
@@ -0,0 +1,87 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#include "crunch/concurrency/atomic.hpp"
+#include "crunch/concurrency/fence.hpp"
+#include "crunch/concurrency/detail/cache_line.hpp"
+#include "crunch/concurrency/detail/system_condition.hpp"
+#include "crunch/concurrency/detail/system_mutex.hpp"
+
+#if defined (CRUNCH_PLATFORM_LINUX)
+#   include "platform/linux/futex.hpp"
+#endif
+
+#include <climits>
+
+namespace Crunch { namespace Concurrency { namespace Detail {
+
+namespace
+{
+    struct ParkingBucket
+    {
+        ParkingBucket() : waiterCount(0, MEMORY_ORDER_RELAXED) {}
+
+        // Threads waiting on any address hashing to this bucket. Lets notifiers skip the lock or syscall.
+        Atomic<std::uint32_t> waiterCount;
+        SystemMutex mutex;
+        SystemCondition condition;
+    };
+
+    std::uint32_t const PARKING_BUCKET_COUNT_LOG2 = 8;
+
+    CacheLineAligned<ParkingBucket> gParkingTable[1 << PARKING_BUCKET_COUNT_LOG2];
+
+    ParkingBucket& GetParkingBucket(void const volatile* address)
+    {
+        // Fibonacci hashing. Low bits are mostly alignment.
+        std::uint64_t const hash = (reinterpret_cast<std::uintptr_t>(address) >> 2) * 0x9e3779b97f4a7c15ull;
+        return gParkingTable[hash >> (64 - PARKING_BUCKET_COUNT_LOG2)].value;
+    }
+
+    bool HasWaiters(ParkingBucket& bucket)
+    {
+        // Pairs with the increment in wait. Either the waiter sees the changed value, or the notifier sees the waiter.
+        CRUNCH_MEMORY_FENCE();
+        return bucket.waiterCount.Load(MEMORY_ORDER_RELAXED) != 0;
+    }
+}
+
+void AtomicParkedWait(void const volatile* address, AtomicWaitPredicate isUnchanged, void const* expected)
+{
+    ParkingBucket& bucket = GetParkingBucket(address);
+    SystemMutex::ScopedLock const lock(bucket.mutex);
+
+    bucket.waiterCount.Increment();
+    if (isUnchanged(address, expected))
+        bucket.condition.Wait(bucket.mutex);
+    bucket.waiterCount.Decrement(MEMORY_ORDER_RELAXED);
+}
+
+void AtomicParkedNotify(void const volatile* address)
+{
+    ParkingBucket& bucket = GetParkingBucket(address);
+    if (!HasWaiters(bucket))
+        return;
+
+    // Waiters check the value under the lock, so they are either asleep or yet to see the change
+    SystemMutex::ScopedLock const lock(bucket.mutex);
+    bucket.condition.WakeAll();
+}
+
+#if defined (CRUNCH_PLATFORM_LINUX)
+void AtomicFutexWait(std::int32_t const volatile* address, std::int32_t expected)
+{
+    ParkingBucket& bucket = GetParkingBucket(address);
+    bucket.waiterCount.Increment();
+    Platform::FutexWait(Platform::GetFutexAddress(address), expected);
+    bucket.waiterCount.Decrement(MEMORY_ORDER_RELAXED);
+}
+
+void AtomicFutexNotify(std::int32_t const volatile* address, bool all)
+{
+    if (HasWaiters(GetParkingBucket(address)))
+        Platform::FutexWake(Platform::GetFutexAddress(address), all ? INT_MAX : 1);
+}
+#endif
+
+}}}
@@ -0,0 +1,171 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#include "crunch/concurrency/barrier.hpp"
+#include "crunch/concurrency/exponential_backoff.hpp"
+#include "crunch/concurrency/waiter_utility.hpp"
+#include "crunch/concurrency/yield.hpp"
+
+namespace Crunch { namespace Concurrency {
+
+Barrier::Barrier(std::uint32_t count, std::uint32_t spinCount)
+    : mCount(count)
+    , mSpinCount(spinCount)
+    , mWaiters(0)
+{
+    CRUNCH_ASSERT_MSG(count != 0, "Barrier must have participants");
+    mRemaining.value.Store(count, MEMORY_ORDER_RELAXED);
+    mPhase.value.Store(0, MEMORY_ORDER_RELEASE);
+}
+
+bool Barrier::Wait()
+{
+    // Phase can't complete before this participant has arrived
+    std::uint32_t const phase = mPhase.value.Load(MEMORY_ORDER_ACQUIRE);
+    if (mRemaining.value.Decrement(MEMORY_ORDER_ACQ_REL) == 1)
+    {
+        Complete(phase, nullptr);
+        return true;
+    }
+
+    for (std::uint32_t i = 0; i < mSpinCount; ++i)
+    {
+        if (mPhase.value.Load(MEMORY_ORDER_ACQUIRE) != phase)
+            return false;
+
+        CRUNCH_PAUSE();
+    }
+
+    mPhase.value.Wait(phase, MEMORY_ORDER_ACQUIRE);
+    return false;
+}
+
+bool Barrier::AddWaiter(Waiter* waiter)
+{
+    std::uint32_t const phase = mPhase.value.Load(MEMORY_ORDER_ACQUIRE);
+
+    // Add waiter before arriving, so the completing participant is guaranteed to find it
+    ExponentialBackoff backoff;
+    std::uint64_t head = mWaiters.Load(MEMORY_ORDER_RELAXED);
+    for (;;)
+    {
+        waiter->next = Detail::WaiterList::GetPointer(head);
+        std::uint64_t const newHead = Detail::WaiterList::SetPointer(head, waiter) + Detail::WaiterList::ABA_ADDEND;
+        if (mWaiters.CompareAndSwap(head, newHead))
+            break;
+
+        backoff.Pause();
+    }
+
+    if (mRemaining.value.Decrement(MEMORY_ORDER_ACQ_REL) != 1)
+        return true;
+
+    Complete(phase, waiter);
+    return false;
+}
+
+bool Barrier::RemoveWaiter(Waiter* waiter)
+{
+    ExponentialBackoff backoff;
+    std::uint64_t head = mWaiters.Load(MEMORY_ORDER_RELAXED);
+    for (;;)
+    {
+        if ((head & Detail::WaiterList::PTR_MASK) == 0)
+            return false;
+
+        // Lock out completion while withdrawing, so the arrival and the waiter go away together
+        if ((head & Detail::WaiterList::LOCK_BIT) == 0 &&
+            mWaiters.CompareAndSwap(head, (head | Detail::WaiterList::LOCK_BIT) + Detail::WaiterList::ABA_ADDEND))
+        {
+            break;
+        }
+
+        backoff.Pause();
+        head = mWaiters.Load(MEMORY_ORDER_RELAXED);
+    }
+
+    // Waiter is gone if its phase has completed. New waiters may still be pushed while locked, but only in front.
+    bool found = false;
+    for (Waiter* current = Detail::WaiterList::GetPointer(head); current != nullptr; current = current->next)
+    {
+        if (current == waiter)
+        {
+            found = true;
+            break;
+        }
+    }
+
+    // Nothing to withdraw once the last participant has arrived either. It is waiting for the lock to notify us.
+    std::uint32_t remaining = mRemaining.value.Load(MEMORY_ORDER_RELAXED);
+    for (;;)
+    {
+        if (!found || remaining == 0)
+        {
+            mWaiters.Unlock();
+            return false;
+        }
+
+        if (mRemaining.value.CompareAndSwap(remaining, remaining + 1))
+            break;
+    }
+
+    // Unlinking from the head needs a CAS because of concurrent pushes
+    head = mWaiters.Load(MEMORY_ORDER_RELAXED);
+    for (;;)
+    {
+        Waiter* const headPtr = Detail::WaiterList::GetPointer(head);
+        if (headPtr != waiter)
+        {
+            RemoveWaiterFromListNotAtHead(headPtr, waiter);
+            break;
+        }
+
+        std::uint64_t const newHead = Detail::WaiterList::SetPointer(head, waiter->next) + Detail::WaiterList::ABA_ADDEND;
+        if (mWaiters.CompareAndSwap(head, newHead))
+            break;
+    }
+
+    mWaiters.Unlock();
+    return true;
+}
+
+bool Barrier::IsOrderDependent() const
+{
+    return false;
+}
+
+void Barrier::Complete(std::uint32_t phase, Waiter* waiter)
+{
+    // Take the waiters of this phase before anyone can arrive for the next
+    ExponentialBackoff backoff;
+    std::uint64_t head = mWaiters.Load(MEMORY_ORDER_RELAXED);
+    for (;;)
+    {
+        if ((head & Detail::WaiterList::LOCK_BIT) == 0)
+        {
+            std::uint64_t const lockedHead =
+                ((head & ~Detail::WaiterList::PTR_MASK) | Detail::WaiterList::LOCK_BIT) + Detail::WaiterList::ABA_ADDEND;
+
+            if (mWaiters.CompareAndSwap(head, lockedHead))
+                break;
+        }
+        else
+        {
+            backoff.Pause();
+            head = mWaiters.Load(MEMORY_ORDER_RELAXED);
+        }
+    }
+
+    Waiter* waiters = Detail::WaiterList::GetPointer(head);
+    if (waiter != nullptr)
+        waiters = RemoveWaiterFromList(waiters, waiter);
+
+    mRemaining.value.Store(mCount, MEMORY_ORDER_RELAXED);
+    mPhase.value.Store(phase + 1, MEMORY_ORDER_RELEASE);
+    mPhase.value.NotifyAll();
+
+    NotifyAllWaiters(waiters);
+    mWaiters.Unlock();
+}
+
+}}
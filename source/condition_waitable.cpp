@@ -0,0 +1,76 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#include "crunch/concurrency/detail/condition_waitable.hpp"
+#include "crunch/concurrency/constant_backoff.hpp"
+#include "crunch/concurrency/exponential_backoff.hpp"
+#include "crunch/concurrency/waiter_utility.hpp"
+
+namespace Crunch { namespace Concurrency { namespace Detail {
+
+bool ConditionWaitable::AddWaiter(Waiter* waiter)
+{
+    if (mIsReady(mContext))
+        return false;
+
+    ConstantBackoff backoff;
+    std::uint64_t head = mWaiters.Load(MEMORY_ORDER_RELAXED);
+    for (;;)
+    {
+        waiter->next = WaiterList::GetPointer(head);
+        std::uint64_t const newHead = WaiterList::SetPointer(head, waiter) + WaiterList::ABA_ADDEND;
+        if (mWaiters.CompareAndSwap(head, newHead))
+            break;
+
+        backoff.Pause();
+    }
+
+    // Pairs with fence in Notify
+    CRUNCH_MEMORY_FENCE();
+
+    if (!mIsReady(mContext))
+        return true;
+
+    // Became ready while adding. If the waiter is already gone, Notify has taken it and will call it.
+    return !mWaiters.RemoveWaiter(waiter);
+}
+
+bool ConditionWaitable::RemoveWaiter(Waiter* waiter)
+{
+    return mWaiters.RemoveWaiter(waiter);
+}
+
+bool ConditionWaitable::IsOrderDependent() const
+{
+    return false;
+}
+
+void ConditionWaitable::NotifyAll()
+{
+    ExponentialBackoff backoff;
+    std::uint64_t head = mWaiters.Load(MEMORY_ORDER_RELAXED);
+    for (;;)
+    {
+        if ((head & WaiterList::PTR_MASK) == 0)
+            return;
+
+        // Wait for list to be unlocked before taking waiters
+        if ((head & WaiterList::LOCK_BIT) == 0)
+        {
+            std::uint64_t const lockedHead = ((head & ~WaiterList::PTR_MASK) | WaiterList::LOCK_BIT) + WaiterList::ABA_ADDEND;
+            if (mWaiters.CompareAndSwap(head, lockedHead))
+            {
+                NotifyAllWaiters(WaiterList::GetPointer(head));
+                mWaiters.Unlock();
+                return;
+            }
+        }
+        else
+        {
+            backoff.Pause();
+            head = mWaiters.Load(MEMORY_ORDER_RELAXED);
+        }
+    }
+}
+
+}}}
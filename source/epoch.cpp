@@ -0,0 +1,245 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#include "crunch/concurrency/epoch.hpp"
+#include "./record_list.hpp"
+
+#include "crunch/base/assert.hpp"
+#include "crunch/concurrency/atomic.hpp"
+#include "crunch/concurrency/fence.hpp"
+#include "crunch/concurrency/thread_local.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace Crunch { namespace Concurrency {
+
+namespace
+{
+    struct RetiredObject
+    {
+        void* object;
+        void (*reclaim)(void*);
+    };
+}
+
+namespace Detail
+{
+    struct EpochRetiredList
+    {
+        EpochRetiredList() : epoch(0) {}
+
+        // Global epoch the objects were retired in
+        std::uint64_t epoch;
+        std::vector<RetiredObject> objects;
+    };
+}
+
+/// Per thread epoch state. Records are never freed while the process runs, and are reused by new threads after the
+/// owning thread exits.
+struct Detail::EpochRecord : NonCopyable
+{
+    static std::uint64_t const ACTIVE_BIT = 1;
+    static std::uint32_t const RETIRED_BUCKET_COUNT = 3;
+
+    EpochRecord()
+        : state(0, MEMORY_ORDER_RELAXED)
+        , inUse(1, MEMORY_ORDER_RELAXED)
+        , nesting(0)
+        , retiredCount(0)
+        , next(nullptr)
+    {}
+
+    // Epoch observed on entry shifted left by one, with ACTIVE_BIT set while in a critical region
+    Atomic<std::uint64_t> state;
+    Atomic<std::uint32_t> inUse;
+
+    // Only accessed by the owning thread
+    std::uint32_t nesting;
+    std::uint32_t retiredCount;
+    EpochRetiredList* retired[RETIRED_BUCKET_COUNT];
+
+    EpochRecord* next;
+};
+
+namespace
+{
+    using Detail::EpochRecord;
+    using Detail::EpochRetiredList;
+
+    Atomic<std::uint64_t> gGlobalEpoch(0, MEMORY_ORDER_RELAXED);
+    CRUNCH_THREAD_LOCAL EpochRecord* tEpochRecord = nullptr;
+
+    // Number of retired objects a thread accumulates before trying to advance the epoch
+    std::uint32_t const RETIRE_BATCH_SIZE = 64;
+
+    void ReclaimObjects(std::vector<RetiredObject>& objects)
+    {
+        // Swap out the list first as reclaim functions may retire further objects
+        std::vector<RetiredObject> reclaimable;
+        reclaimable.swap(objects);
+        std::for_each(reclaimable.begin(), reclaimable.end(), [] (RetiredObject const& retired)
+        {
+            retired.reclaim(retired.object);
+        });
+    }
+
+    class EpochDomain
+    {
+    public:
+        ~EpochDomain()
+        {
+            // No other threads may be in a critical region at this point
+            for (EpochRecord* record = mRecords.GetHead(); record; record = record->next)
+            {
+                for (std::uint32_t i = 0; i < EpochRecord::RETIRED_BUCKET_COUNT; ++i)
+                {
+                    ReclaimObjects(record->retired[i]->objects);
+                    delete record->retired[i];
+                }
+            }
+        }
+
+        EpochRecord* Acquire()
+        {
+            return mRecords.Acquire([]
+            {
+                EpochRecord* const record = new EpochRecord();
+                for (std::uint32_t i = 0; i < EpochRecord::RETIRED_BUCKET_COUNT; ++i)
+                    record->retired[i] = new EpochRetiredList();
+                return record;
+            });
+        }
+
+        void Release(EpochRecord* record)
+        {
+            CRUNCH_ASSERT_MSG(record->nesting == 0, "Releasing epoch record inside critical region");
+            mRecords.Release(record);
+        }
+
+        /// Advance the global epoch if every thread in a critical region has observed the current one
+        /// \return Current global epoch after the attempt
+        std::uint64_t TryAdvance()
+        {
+            // Pairs with fence on critical region entry. Objects retired before this point were unlinked before any
+            // thread that we see inactive, or in the current epoch, could have entered.
+            CRUNCH_MEMORY_FENCE();
+
+            std::uint64_t epoch = gGlobalEpoch.Load(MEMORY_ORDER_ACQUIRE);
+            for (EpochRecord* record = mRecords.GetHead(); record; record = record->next)
+            {
+                std::uint64_t const state = record->state.Load(MEMORY_ORDER_ACQUIRE);
+                if ((state & EpochRecord::ACTIVE_BIT) != 0 && (state >> 1) != epoch)
+                    return epoch;
+            }
+
+            // Fails if another thread advanced it first, which is just as good
+            gGlobalEpoch.CompareAndSwap(epoch, epoch + 1);
+            return gGlobalEpoch.Load(MEMORY_ORDER_ACQUIRE);
+        }
+
+        /// Reclaim buckets retired at least two epochs ago. Any thread in a critical region then has entered after
+        /// the objects were unlinked.
+        void ReclaimSafe(EpochRecord& record, std::uint64_t epoch)
+        {
+            for (std::uint32_t i = 0; i < EpochRecord::RETIRED_BUCKET_COUNT; ++i)
+            {
+                EpochRetiredList& bucket = *record.retired[i];
+                if (!bucket.objects.empty() && epoch - bucket.epoch >= 2)
+                {
+                    record.retiredCount -= static_cast<std::uint32_t>(bucket.objects.size());
+                    ReclaimObjects(bucket.objects);
+                }
+            }
+        }
+
+        void Retire(EpochRecord& record, void* object, void (*reclaim)(void*))
+        {
+            std::uint64_t const epoch = gGlobalEpoch.Load(MEMORY_ORDER_ACQUIRE);
+            EpochRetiredList& bucket = *record.retired[epoch % EpochRecord::RETIRED_BUCKET_COUNT];
+            if (bucket.epoch != epoch)
+            {
+                // Bucket last used three or more epochs ago, so anything left in it is safe
+                record.retiredCount -= static_cast<std::uint32_t>(bucket.objects.size());
+                ReclaimObjects(bucket.objects);
+                bucket.epoch = epoch;
+            }
+
+            RetiredObject const retired = { object, reclaim };
+            bucket.objects.push_back(retired);
+            record.retiredCount++;
+
+            if (record.retiredCount >= RETIRE_BATCH_SIZE && record.nesting == 0)
+                ReclaimSafe(record, TryAdvance());
+        }
+
+        void Quiesce(EpochRecord& record)
+        {
+            if (record.retiredCount == 0)
+                return;
+
+            ReclaimSafe(record, TryAdvance());
+        }
+
+    private:
+        Detail::RecordList<EpochRecord> mRecords;
+    };
+
+    EpochDomain gEpochDomain;
+
+    EpochRecord* AcquireEpochRecord()
+    {
+        if (tEpochRecord == nullptr)
+            tEpochRecord = gEpochDomain.Acquire();
+
+        return tEpochRecord;
+    }
+}
+
+namespace Detail
+{
+    void ReleaseEpochRecord()
+    {
+        if (tEpochRecord != nullptr)
+        {
+            gEpochDomain.Release(tEpochRecord);
+            tEpochRecord = nullptr;
+        }
+    }
+}
+
+Epoch::Guard::Guard()
+    : mRecord(AcquireEpochRecord())
+{
+    if (mRecord->nesting++ == 0)
+    {
+        std::uint64_t const epoch = gGlobalEpoch.Load(MEMORY_ORDER_RELAXED);
+        mRecord->state.Store((epoch << 1) | EpochRecord::ACTIVE_BIT, MEMORY_ORDER_RELAXED);
+
+        // Publish entry before accessing shared state. Pairs with fence in epoch advance.
+        CRUNCH_MEMORY_FENCE();
+    }
+}
+
+Epoch::Guard::~Guard()
+{
+    if (--mRecord->nesting == 0)
+        mRecord->state.Store(mRecord->state.Load(MEMORY_ORDER_RELAXED) & ~EpochRecord::ACTIVE_BIT, MEMORY_ORDER_RELEASE);
+}
+
+void Epoch::Retire(void* object, void (*reclaim)(void*))
+{
+    gEpochDomain.Retire(*AcquireEpochRecord(), object, reclaim);
+}
+
+void Epoch::Quiesce()
+{
+    if (EpochRecord* const record = tEpochRecord)
+    {
+        CRUNCH_ASSERT_MSG(record->nesting == 0, "Quiescent state inside critical region");
+        gEpochDomain.Quiesce(*record);
+    }
+}
+
+}}
@@ -0,0 +1,235 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#include "crunch/concurrency/grace_period.hpp"
+
+#include "crunch/base/assert.hpp"
+#include "crunch/concurrency/atomic.hpp"
+#include "crunch/concurrency/fence.hpp"
+#include "crunch/concurrency/thread_local.hpp"
+#include "crunch/concurrency/detail/system_mutex.hpp"
+#include "./record_list.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace Crunch { namespace Concurrency {
+
+/// Per thread reader state. Records are never freed while the process runs, and are reused by new threads after
+/// the owning thread unregisters.
+struct Detail::GracePeriodRecord : NonCopyable
+{
+    static std::uint64_t const OFFLINE = ~std::uint64_t(0);
+
+    GracePeriodRecord()
+        : period(OFFLINE, MEMORY_ORDER_RELAXED)
+        , inUse(1, MEMORY_ORDER_RELAXED)
+        , readerNesting(0)
+        , offlineNesting(0)
+        , next(nullptr)
+    {}
+
+    // Global period observed at the last quiescent state, or OFFLINE
+    Atomic<std::uint64_t> period;
+    Atomic<std::uint32_t> inUse;
+
+    // Only accessed by the owning thread
+    std::uint32_t readerNesting;
+    std::uint32_t offlineNesting;
+
+    GracePeriodRecord* next;
+};
+
+namespace
+{
+    using Detail::GracePeriodRecord;
+
+    struct RetiredObject
+    {
+        void* object;
+        void (*reclaim)(void*);
+
+        // Global period after the object was retired. Safe once every online reader has observed it.
+        std::uint64_t period;
+    };
+
+    CRUNCH_THREAD_LOCAL GracePeriodRecord* tGracePeriodRecord = nullptr;
+
+    void ReclaimObjects(std::vector<RetiredObject>& objects)
+    {
+        std::for_each(objects.begin(), objects.end(), [] (RetiredObject const& retired)
+        {
+            retired.reclaim(retired.object);
+        });
+    }
+
+    class GracePeriodDomain
+    {
+    public:
+        GracePeriodDomain()
+            : mPeriod(0, MEMORY_ORDER_RELAXED)
+            , mRetiredCount(0, MEMORY_ORDER_RELAXED)
+        {}
+
+        ~GracePeriodDomain()
+        {
+            // No other threads may be reading at this point
+            ReclaimObjects(mRetired);
+        }
+
+        GracePeriodRecord* Acquire()
+        {
+            return mRecords.Acquire();
+        }
+
+        void Release(GracePeriodRecord* record)
+        {
+            CRUNCH_ASSERT_MSG(record->offlineNesting == 0, "Releasing grace period record while offline");
+            mRecords.Release(record);
+        }
+
+        void GoOnline(GracePeriodRecord& record)
+        {
+            record.period.Store(mPeriod.Load(MEMORY_ORDER_ACQUIRE), MEMORY_ORDER_RELAXED);
+
+            // Pairs with fence in TryReclaim. Either the reclaimer sees this thread online, or this thread sees the
+            // retired objects unlinked.
+            CRUNCH_MEMORY_FENCE();
+        }
+
+        void GoOffline(GracePeriodRecord& record)
+        {
+            record.period.Store(GracePeriodRecord::OFFLINE, MEMORY_ORDER_RELEASE);
+        }
+
+        void Quiesce(GracePeriodRecord& record)
+        {
+            // Release orders all prior reads of shared objects before the new period is observed by a reclaimer
+            record.period.Store(mPeriod.Load(MEMORY_ORDER_ACQUIRE), MEMORY_ORDER_RELEASE);
+        }
+
+        void Retire(void* object, void (*reclaim)(void*))
+        {
+            // Object has been unlinked before the period is advanced, so a reader that observes the new period, or
+            // goes online after it, can't reach it
+            std::uint64_t const period = mPeriod.Increment() + 1;
+
+            {
+                Detail::SystemMutex::ScopedLock const lock(mRetiredLock);
+                RetiredObject const retired = { object, reclaim, period };
+                mRetired.push_back(retired);
+            }
+
+            mRetiredCount.Increment(MEMORY_ORDER_RELAXED);
+            TryReclaim();
+        }
+
+        bool HasRetired() const
+        {
+            return mRetiredCount.Load(MEMORY_ORDER_RELAXED) != 0;
+        }
+
+        /// Reclaim objects retired in a period every online reader has observed
+        void TryReclaim()
+        {
+            // Pairs with fence on going online
+            CRUNCH_MEMORY_FENCE();
+
+            std::uint64_t safePeriod = mPeriod.Load(MEMORY_ORDER_ACQUIRE);
+            for (GracePeriodRecord* record = mRecords.GetHead(); record; record = record->next)
+                safePeriod = std::min(safePeriod, record->period.Load(MEMORY_ORDER_ACQUIRE));
+
+            std::vector<RetiredObject> reclaimable;
+            {
+                Detail::SystemMutex::ScopedLock const lock(mRetiredLock);
+                auto const unsafeBegin = std::partition(mRetired.begin(), mRetired.end(), [=] (RetiredObject const& retired)
+                {
+                    return retired.period <= safePeriod;
+                });
+                reclaimable.assign(mRetired.begin(), unsafeBegin);
+                mRetired.erase(mRetired.begin(), unsafeBegin);
+            }
+
+            if (reclaimable.empty())
+                return;
+
+            mRetiredCount.Sub(static_cast<std::uint32_t>(reclaimable.size()), MEMORY_ORDER_RELAXED);
+
+            // Reclaim outside the lock as reclaim functions may retire further objects
+            ReclaimObjects(reclaimable);
+        }
+
+    private:
+        Detail::RecordList<GracePeriodRecord> mRecords;
+        Atomic<std::uint64_t> mPeriod;
+        Atomic<std::uint32_t> mRetiredCount;
+
+        Detail::SystemMutex mRetiredLock;
+        std::vector<RetiredObject> mRetired;
+    };
+
+    GracePeriodDomain gGracePeriodDomain;
+}
+
+GracePeriod::Reader::Reader()
+{
+    if (tGracePeriodRecord == nullptr)
+        tGracePeriodRecord = gGracePeriodDomain.Acquire();
+
+    GracePeriodRecord& record = *tGracePeriodRecord;
+    CRUNCH_ASSERT_MSG(record.offlineNesting == 0, "Registering reader while offline");
+    if (record.readerNesting++ == 0)
+        gGracePeriodDomain.GoOnline(record);
+}
+
+GracePeriod::Reader::~Reader()
+{
+    GracePeriodRecord* const record = tGracePeriodRecord;
+    CRUNCH_ASSERT(record != nullptr && record->readerNesting > 0);
+    if (--record->readerNesting == 0)
+    {
+        gGracePeriodDomain.GoOffline(*record);
+        gGracePeriodDomain.Release(record);
+        tGracePeriodRecord = nullptr;
+
+        if (gGracePeriodDomain.HasRetired())
+            gGracePeriodDomain.TryReclaim();
+    }
+}
+
+GracePeriod::Offline::Offline()
+    : mRecord(tGracePeriodRecord)
+{
+    if (mRecord != nullptr && mRecord->offlineNesting++ == 0)
+    {
+        gGracePeriodDomain.GoOffline(*mRecord);
+
+        // This thread might be the one holding up reclamation
+        if (gGracePeriodDomain.HasRetired())
+            gGracePeriodDomain.TryReclaim();
+    }
+}
+
+GracePeriod::Offline::~Offline()
+{
+    if (mRecord != nullptr && --mRecord->offlineNesting == 0)
+        gGracePeriodDomain.GoOnline(*mRecord);
+}
+
+void GracePeriod::Retire(void* object, void (*reclaim)(void*))
+{
+    gGracePeriodDomain.Retire(object, reclaim);
+}
+
+void GracePeriod::Quiesce()
+{
+    GracePeriodRecord* const record = tGracePeriodRecord;
+    if (record != nullptr && record->offlineNesting == 0)
+        gGracePeriodDomain.Quiesce(*record);
+
+    if (gGracePeriodDomain.HasRetired())
+        gGracePeriodDomain.TryReclaim();
+}
+
+}}
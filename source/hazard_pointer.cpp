@@ -0,0 +1,168 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#include "crunch/concurrency/hazard_pointer.hpp"
+#include "crunch/concurrency/thread_local.hpp"
+
+#include "./record_list.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace Crunch { namespace Concurrency {
+
+namespace
+{
+    struct RetiredObject
+    {
+        void* object;
+        void (*reclaim)(void*);
+    };
+}
+
+struct Detail::HazardPointerRetiredList
+{
+    std::vector<RetiredObject> objects;
+};
+
+namespace
+{
+    using Detail::HazardPointerRecord;
+
+    // Scan once the retired count of a record reaches this multiple of the total record count, which bounds the
+    // amortized cost of a scan to O(1) per retired object
+    std::uint32_t const SCAN_FACTOR = 2;
+    std::uint32_t const SCAN_MIN_THRESHOLD = 64;
+
+    class HazardPointerDomain
+    {
+    public:
+        HazardPointerDomain()
+            : mRecordCount(0, MEMORY_ORDER_RELAXED)
+        {}
+
+        ~HazardPointerDomain()
+        {
+            // No other threads may hold hazards at this point
+            for (HazardPointerRecord* record = mRecords.GetHead(); record; record = record->next)
+            {
+                std::for_each(record->retired->objects.begin(), record->retired->objects.end(), [] (RetiredObject const& retired)
+                {
+                    retired.reclaim(retired.object);
+                });
+                delete record->retired;
+            }
+        }
+
+        HazardPointerRecord* Acquire(HazardPointerRecord* hint)
+        {
+            if (hint && RecordList::TryAcquire(*hint))
+                return hint;
+
+            return mRecords.Acquire([this]
+            {
+                HazardPointerRecord* const record = new HazardPointerRecord();
+                record->retired = new Detail::HazardPointerRetiredList();
+                mRecordCount.Increment();
+                return record;
+            });
+        }
+
+        void Release(HazardPointerRecord* record)
+        {
+            mRecords.Release(record);
+        }
+
+        void Retire(HazardPointerRecord& record, void* object, void (*reclaim)(void*))
+        {
+            RetiredObject const retired = { object, reclaim };
+            std::vector<RetiredObject>& objects = record.retired->objects;
+            objects.push_back(retired);
+
+            std::uint32_t const threshold = std::max(SCAN_MIN_THRESHOLD, SCAN_FACTOR * mRecordCount.Load(MEMORY_ORDER_RELAXED));
+            if (objects.size() >= threshold)
+                Scan(record);
+        }
+
+        void Scan(HazardPointerRecord& record)
+        {
+            // Retired objects were unlinked before this point. Pairs with the fence in HazardPointer::Set so that
+            // either the reader's validation fails, or we observe its hazard.
+            CRUNCH_MEMORY_FENCE();
+
+            std::vector<void*> hazards;
+            hazards.reserve(mRecordCount.Load(MEMORY_ORDER_RELAXED));
+            for (HazardPointerRecord* r = mRecords.GetHead(); r; r = r->next)
+            {
+                if (void* const hazard = r->hazard.Load(MEMORY_ORDER_ACQUIRE))
+                    hazards.push_back(hazard);
+            }
+
+            std::sort(hazards.begin(), hazards.end());
+
+            // Swap out the list first as reclaim functions may retire further objects
+            std::vector<RetiredObject> candidates;
+            candidates.swap(record.retired->objects);
+
+            std::for_each(candidates.begin(), candidates.end(), [&] (RetiredObject const& retired)
+            {
+                if (std::binary_search(hazards.begin(), hazards.end(), retired.object))
+                    record.retired->objects.push_back(retired);
+                else
+                    retired.reclaim(retired.object);
+            });
+        }
+
+        void ScanAll()
+        {
+            for (HazardPointerRecord* record = mRecords.GetHead(); record; record = record->next)
+            {
+                if (RecordList::TryAcquire(*record))
+                {
+                    Scan(*record);
+                    Release(record);
+                }
+            }
+        }
+
+    private:
+        typedef Detail::RecordList<HazardPointerRecord> RecordList;
+
+        RecordList mRecords;
+        Atomic<std::uint32_t> mRecordCount;
+    };
+
+    HazardPointerDomain gHazardPointerDomain;
+
+    // Record last used by this thread. Usually free and uncontended, which avoids scanning the record list.
+    CRUNCH_THREAD_LOCAL HazardPointerRecord* tRecordHint = nullptr;
+}
+
+namespace Detail
+{
+    HazardPointerRecord* AcquireHazardPointerRecord()
+    {
+        HazardPointerRecord* const record = gHazardPointerDomain.Acquire(tRecordHint);
+        tRecordHint = record;
+        return record;
+    }
+
+    void ReleaseHazardPointerRecord(HazardPointerRecord* record)
+    {
+        gHazardPointerDomain.Release(record);
+    }
+}
+
+void HazardPointer::Retire(void* object, void (*reclaim)(void*))
+{
+    HazardPointerRecord* const record = Detail::AcquireHazardPointerRecord();
+    gHazardPointerDomain.Retire(*record, object, reclaim);
+    Detail::ReleaseHazardPointerRecord(record);
+}
+
+void HazardPointer::ReclaimAll()
+{
+    gHazardPointerDomain.ScanAll();
+}
+
+}}
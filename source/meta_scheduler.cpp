@@ -9,7 +9,9 @@
 #include "crunch/base/noncopyable.hpp"
 #include "crunch/base/override.hpp"
 #include "crunch/base/stack_alloc.hpp"
+#include "crunch/concurrency/epoch.hpp"
 #include "crunch/concurrency/event.hpp"
+#include "crunch/concurrency/grace_period.hpp"
 #include "crunch/concurrency/yield.hpp"
 #include "crunch/concurrency/detail/system_semaphore.hpp"
 
@@ -20,13 +22,60 @@ namespace Crunch { namespace Concurrency {
 
 namespace
 {
-    void WaitForImpl(Detail::SystemSemaphore& waitSemaphore, IWaitable& waitable, WaitMode waitMode)
+    /// Tracks the remaining time budget of a wait spanning several blocking steps
+    class WaitDeadline
     {
-        if (waitable.AddWaiter([&] { waitSemaphore.Post(); }))
-            waitSemaphore.SpinWait(waitMode.spinCount);
+    public:
+        WaitDeadline(Duration timeout)
+            : mTimeout(timeout)
+            , mStart(timeout.IsPosInfinity() ? 0 : mTimer.Sample())
+        {}
+
+        bool HasExpired() const
+        {
+            return !mTimeout.IsPosInfinity() && mTimer.GetElapsedTime(mStart, mTimer.Sample()) >= mTimeout;
+        }
+
+        WaitMode GetRemaining(WaitMode waitMode) const
+        {
+            if (mTimeout.IsPosInfinity())
+                return waitMode;
+
+            return waitMode.WithTimeout(mTimeout - mTimer.GetElapsedTime(mStart, mTimer.Sample()));
+        }
+
+    private:
+        HighFrequencyTimer mTimer;
+        Duration mTimeout;
+        HighFrequencyTimer::SampleType mStart;
+    };
+
+    /// \return false if timed out, in which case the waiter has been removed
+    bool WaitForWaiter(Detail::SystemSemaphore& waitSemaphore, IWaitable& waitable, Waiter* waiter, WaitMode waitMode)
+    {
+        if (!waitable.AddWaiter(waiter))
+            return true;
+
+        if (waitSemaphore.SpinWait(waitMode.spinCount, waitMode.timeout))
+            return true;
+
+        if (waitable.RemoveWaiter(waiter))
+            return false;
+
+        // Notified after all. Wait for the in-flight callback.
+        waitSemaphore.Wait();
+        return true;
     }
 
-    void WaitForAllImpl(Detail::SystemSemaphore& waitSemaphore, IWaitable** waitables, std::size_t count, WaitMode waitMode)
+    bool WaitForImpl(Detail::SystemSemaphore& waitSemaphore, IWaitable& waitable, WaitMode waitMode)
+    {
+        auto waiter = Waiter::Create([&] { waitSemaphore.Post(); }, false);
+        bool const notified = WaitForWaiter(waitSemaphore, waitable, waiter, waitMode);
+        waiter->Destroy();
+        return notified;
+    }
+
+    bool WaitForAllImpl(Detail::SystemSemaphore& waitSemaphore, IWaitable** waitables, std::size_t count, WaitMode waitMode)
     {
         IWaitable** unordered = CRUNCH_STACK_ALLOC_T(IWaitable*, count);
         IWaitable** ordered = CRUNCH_STACK_ALLOC_T(IWaitable*, count);
@@ -41,43 +90,121 @@ namespace
                 unordered[unorderedCount++] = waitables[i];
         }
 
+        WaitDeadline const deadline(waitMode.timeout);
+
         if (orderedCount != 0)
         {
+            // Waitables acquired before a timeout would stay acquired with no way for the caller to tell which
+            CRUNCH_ASSERT_MSG_ALWAYS(waitMode.timeout.IsPosInfinity(), "Timed WaitForAll on order dependent waitables");
+
             std::sort(ordered, ordered + orderedCount);
 
-            // Order dependent doesn't imply fair, so we need to wait for one at a time
+            // Order dependent doesn't imply fair, so we need to wait for one at a time. Those already acquired are
+            // held while waiting for the rest, so don't run other work that could need them.
+            WaitMode const blockMode(waitMode.spinCount, false);
             for (std::size_t i = 0; i < orderedCount; ++i)
-                WaitFor(*ordered[i], waitMode);
+                WaitFor(*ordered[i], blockMode);
         }
 
         if (unorderedCount != 0)
         {
+            auto poster = [&] { waitSemaphore.Post(); };
+            typedef Waiter::Typed<decltype(poster)> WaiterType;
+
+            WaiterType** waiters = CRUNCH_STACK_ALLOC_T(WaiterType*, unorderedCount);
+            IWaitable** added = CRUNCH_STACK_ALLOC_T(IWaitable*, unorderedCount);
+
             std::size_t addedCount = 0;
             for (std::size_t i = 0; i < unorderedCount; ++i)
-                if (waitables[i]->AddWaiter([&] { waitSemaphore.Post(); }))
-                    addedCount++;
+            {
+                WaiterType* const waiter = Waiter::Create(poster, false);
+                if (unordered[i]->AddWaiter(waiter))
+                {
+                    waiters[addedCount] = waiter;
+                    added[addedCount++] = unordered[i];
+                }
+                else
+                {
+                    waiter->Destroy();
+                }
+            }
+
+            // Posts outstanding
+            std::size_t pendingCount = addedCount;
+            while (pendingCount != 0 && waitSemaphore.SpinWait(waitMode.spinCount, deadline.GetRemaining(waitMode).timeout))
+                pendingCount--;
+
+            bool const timedOut = pendingCount != 0;
+            if (timedOut)
+            {
+                // Timed out. Waiters that can't be removed have been or are being notified.
+                for (std::size_t i = 0; i < addedCount; ++i)
+                    if (added[i]->RemoveWaiter(waiters[i]))
+                        pendingCount--;
+
+                for (std::size_t i = 0; i < pendingCount; ++i)
+                    waitSemaphore.Wait();
+            }
 
             for (std::size_t i = 0; i < addedCount; ++i)
-                waitSemaphore.SpinWait(waitMode.spinCount);
+                waiters[i]->Destroy();
+
+            return !timedOut;
         }
+
+        return true;
     }
 
-    WaitForAnyResult WaitForAnyImpl(Detail::SystemSemaphore& waitSemaphore, IWaitable** waitables, std::size_t count, WaitMode waitMode)
+    /// Notification slot shared by all waiters of a WaitForAny call. Only the first notification posts the semaphore.
+    struct WaitForAnySlot
     {
-        auto poster = [&] { waitSemaphore.Post(); };
-        typedef Waiter::Typed<decltype(poster)> WaiterType;
+        WaitForAnySlot(Detail::SystemSemaphore& semaphore)
+            : semaphore(semaphore)
+            , notifiedCount(0)
+        {}
+
+        Detail::SystemSemaphore& semaphore;
+
+        // Number of waiter callbacks that have completed
+        Atomic<std::uint32_t> notifiedCount;
+    };
 
-        WaiterType** waiters = CRUNCH_STACK_ALLOC_T(WaiterType*, count);
+    // Waiter blocks up to this size are allocated on the stack
+    std::size_t const WAIT_FOR_ANY_STACK_LIMIT = 4096;
+
+    WaitForAnyResult WaitForAnyImpl(Detail::SystemSemaphore& waitSemaphore, IWaitable** waitables, std::size_t count, WaitMode waitMode)
+    {
+        WaitForAnySlot slot(waitSemaphore);
+        WaitForAnySlot* const slotPtr = &slot;
+        auto notifier = [=]
+        {
+            if (slotPtr->notifiedCount.Increment() == 0)
+                slotPtr->semaphore.Post();
+        };
+        typedef Waiter::Typed<decltype(notifier)> WaiterType;
+
+        // All waiters in one block, released together when done
+        std::size_t const blockSize = sizeof(WaiterType) * count;
+        std::unique_ptr<char[]> heapBlock;
+        WaiterType* waiters;
+        if (blockSize <= WAIT_FOR_ANY_STACK_LIMIT)
+        {
+            waiters = CRUNCH_STACK_ALLOC_T(WaiterType, count);
+        }
+        else
+        {
+            heapBlock.reset(new char[blockSize]);
+            waiters = reinterpret_cast<WaiterType*>(heapBlock.get());
+        }
 
         WaitForAnyResult signaled;
 
         std::size_t addedCount = 0;
         for (std::size_t i = 0; i < count; ++i)
         {
-            waiters[i] = Waiter::Create(poster, false);
-            if (!waitables[i]->AddWaiter(waiters[i]))
+            WaiterType* const waiter = Waiter::CreateInPlace(&waiters[i], notifier);
+            if (!waitables[i]->AddWaiter(waiter))
             {
-                waiters[i]->Destroy();
                 signaled.push_back(waitables[i]);
                 break;
             }
@@ -85,26 +212,29 @@ namespace
         }
 
         // If no waitable synchronously ready, wait for one to become ready
-        if (addedCount == count)
-            waitSemaphore.SpinWait(waitMode.spinCount);
+        bool const notified = addedCount == count && waitSemaphore.SpinWait(waitMode.spinCount, waitMode.timeout);
 
         // Try to remove waiters for all waitables
+        std::uint32_t inFlightCount = 0;
         for (std::size_t i = 0; i < addedCount; ++i)
         {
-            if (!waitables[i]->RemoveWaiter(waiters[i]))
+            if (!waitables[i]->RemoveWaiter(&waiters[i]))
+            {
                 signaled.push_back(waitables[i]);
+                inFlightCount++;
+            }
         }
 
-        // Wait for any waiters that weren't removed. They should be in-flight callbacks.
-        // We've already waited for 1 either in SpinWait or by synchronous ready, so start count from 1
-        CRUNCH_ASSERT(signaled.size() >= 1);
-        for (std::size_t i = 1; i < signaled.size(); ++i)
-            waitSemaphore.SpinWait(waitMode.spinCount);
+        if (inFlightCount != 0)
+        {
+            // Consume the single post, unless already done above, and let the rest of the callbacks finish with the
+            // slot. They have already been unlinked by their notifier, so this doesn't take long.
+            if (!notified)
+                waitSemaphore.Wait();
 
-        // Destroy all waiters
-        // TODO: Could bulk free. Callback shouldn't require destruction, so only list of waiters need to be reclaimed.
-        for (std::size_t i = 0; i < addedCount; ++i)
-            waiters[i]->Destroy();
+            while (slot.notifiedCount.Load(MEMORY_ORDER_ACQUIRE) != inFlightCount)
+                ThreadYield();
+        }
 
         return signaled;
     }
@@ -162,6 +292,7 @@ public:
         : mOwner(owner)
         , mWaitSemaphore(0)
         , mRefCount(1)
+        , mCooperativeDepth(0)
     {
         auto waiter = Waiter::Create([&] { mWaitSemaphore.Post(); }, false);
         mWaiterDestroyer = [=] { waiter->Destroy(); };
@@ -304,8 +435,9 @@ public:
             }
         }
 
-        SchedulerState(ISchedulerContext* context, RunMode runMode, std::function<void ()> const& notifyReady)
-            : context(context)
+        SchedulerState(IScheduler& scheduler, RunMode runMode, std::function<void ()> const& notifyReady)
+            : scheduler(scheduler)
+            , context(&scheduler.GetContext())
             , lastState(ISchedulerContext::State::Working)
             , hasWorkCondition(&context->GetHasWorkCondition())
             , runMode(runMode)
@@ -318,8 +450,10 @@ public:
         ~SchedulerState()
         {
             hasWorkWaiter->Destroy();
+            scheduler.ReleaseContext(*context);
         }
 
+        IScheduler& scheduler;
         ISchedulerContext* context;
         volatile ISchedulerContext::State lastState;
         IWaitable* hasWorkCondition;
@@ -363,7 +497,7 @@ public:
             if (runMode.mType != runMode.TYPE_DISABLED)
             {
                 std::size_t index = schedulers.size();
-                schedulers.push_back(std::unique_ptr<SchedulerState>(new SchedulerState(&it->scheduler->GetContext(), runMode, [&, index]
+                schedulers.push_back(std::unique_ptr<SchedulerState>(new SchedulerState(*it->scheduler, runMode, [&, index]
                 {
                     Detail::SystemMutex::ScopedLock const lock(stateLock);
                     if (activeCount++ == 0)
@@ -374,6 +508,16 @@ public:
             }
         }
 
+        // Tasks may read grace period protected objects
+        GracePeriod::Reader const gracePeriodReader;
+
+        // Schedulers that cooperative waits on this thread may run
+        std::for_each(schedulers.begin(), schedulers.end(), [&] (std::unique_ptr<SchedulerState> const& schedulerState)
+        {
+            if (schedulerState->context->CanReEnter())
+                mReEntrantContexts.push_back(schedulerState->context);
+        });
+
         std::size_t pollingCount = 0;
         activeCount = schedulers.size();
         std::vector<SchedulerState*> activeSchedulers;
@@ -451,10 +595,16 @@ public:
                 }
             }
 
+            // No scheduler is running on this thread, so it can't be inside an epoch critical region or hold
+            // references to grace period protected objects
+            Epoch::Quiesce();
+            GracePeriod::Quiesce();
+
             if (activeSchedulers.empty())
             {
                 // No active schedulers, go idle.
                 // TODO: IWaitable until must also notify state changed
+                GracePeriod::Offline const offline;
                 Detail::SystemMutex::ScopedLock const lock(stateLock);
                 while (activeCount == 0)
                 {
@@ -474,6 +624,8 @@ public:
         }
 
 stopped:
+        mReEntrantContexts.clear();
+
         // TODO: remove all waiters on idle schedulers
         {
             Detail::SystemMutex::ScopedLock lock(stateLock);
@@ -503,17 +655,148 @@ stopped:
         }
     }
 
-    CRUNCH_ALWAYS_INLINE void WaitFor(IWaitable& waitable, WaitMode waitMode)
+    CRUNCH_ALWAYS_INLINE bool WaitFor(IWaitable& waitable, WaitMode waitMode)
     {
-        // TODO: Let active scheduler handle the wait if it can
         // TODO: Keep in mind if active scheduler is a fiber scheduler we might come back on a different system thread.. (and this thread might be used for other things.. i.e. waiter must be stack local)
-        if (waitable.AddWaiter(mWaiter))
-            mWaitSemaphore.SpinWait(waitMode.spinCount);
+
+        // Order dependent waitables, like mutexes, hand over ownership on notify. Work run while waiting could need
+        // what has just been acquired, so always block on those.
+        if (waitMode.runCooperative && !waitable.IsOrderDependent() && !mReEntrantContexts.empty() && mCooperativeDepth < MAX_COOPERATIVE_DEPTH)
+            return WaitForCooperatively(waitable, waitMode);
+
+        return WaitForWaiter(mWaitSemaphore, waitable, mWaiter, waitMode);
     }
 
-    CRUNCH_ALWAYS_INLINE void WaitForAll(IWaitable** waitables, std::size_t count, WaitMode waitMode)
+    /// Notification slot shared by the has work waiters of one idle round of a cooperative wait. Only the first
+    /// notification posts the semaphore.
+    struct HasWorkSlot
     {
-        WaitForAllImpl(mWaitSemaphore, waitables, count, waitMode);
+        HasWorkSlot(Detail::SystemSemaphore& semaphore)
+            : semaphore(semaphore)
+            , notifiedCount(0)
+            , doneCount(0)
+        {}
+
+        Detail::SystemSemaphore& semaphore;
+        Atomic<std::uint32_t> notifiedCount;
+
+        // Number of waiter callbacks that have completed, including the post
+        Atomic<std::uint32_t> doneCount;
+    };
+
+    /// Run work from re-entrant schedulers on this thread until waitable is ready. Once there is no work left, sleeps
+    /// until either the waitable or the has work condition of one of the schedulers is notified.
+    bool WaitForCooperatively(IWaitable& waitable, WaitMode waitMode)
+    {
+        // Work run below may wait on this context as well, so use a semaphore and waiter of our own
+        Detail::SystemSemaphore readySemaphore(0);
+        volatile bool ready = false;
+        auto waiter = Waiter::Create([&]
+        {
+            ready = true;
+            readySemaphore.Post();
+        }, false);
+
+        if (!waitable.AddWaiter(waiter))
+        {
+            waiter->Destroy();
+            return true;
+        }
+
+        WaitDeadline const deadline(waitMode.timeout);
+
+        struct Throttler : IThrottler, NonCopyable
+        {
+            Throttler(volatile bool& ready, WaitDeadline const& deadline) : mReady(ready), mDeadline(deadline) {}
+
+            virtual bool ShouldYield() CRUNCH_OVERRIDE
+            {
+                return mReady || mDeadline.HasExpired();
+            }
+
+            volatile bool& mReady;
+            WaitDeadline const& mDeadline;
+        };
+
+        Throttler throttler(ready, deadline);
+
+        HasWorkSlot slot(readySemaphore);
+        HasWorkSlot* const slotPtr = &slot;
+        auto notifier = [=]
+        {
+            if (slotPtr->notifiedCount.Increment() == 0)
+                slotPtr->semaphore.Post();
+            slotPtr->doneCount.Increment();
+        };
+        typedef Waiter::Typed<decltype(notifier)> HasWorkWaiterType;
+
+        std::size_t const contextCount = mReEntrantContexts.size();
+        HasWorkWaiterType* hasWorkWaiters = CRUNCH_STACK_ALLOC_T(HasWorkWaiterType, contextCount);
+
+        // Posts to readySemaphore by has work waiters less those consumed. Negative once the post of the ready waiter
+        // has been consumed in their place.
+        int unconsumedCount = 0;
+
+        mCooperativeDepth++;
+        while (!throttler.ShouldYield())
+        {
+            bool hasWork = false;
+            for (std::size_t i = 0; i < contextCount && !throttler.ShouldYield(); ++i)
+            {
+                if (mReEntrantContexts[i]->Run(throttler) != ISchedulerContext::State::Idle)
+                    hasWork = true;
+            }
+
+            if (hasWork || throttler.ShouldYield())
+                continue;
+
+            // All schedulers idle. Sleep until one has work or the waitable is ready.
+            slot.notifiedCount.Store(0, MEMORY_ORDER_RELAXED);
+            slot.doneCount.Store(0, MEMORY_ORDER_RELAXED);
+
+            std::size_t addedCount = 0;
+            for (; addedCount < contextCount; ++addedCount)
+            {
+                HasWorkWaiterType* const hasWorkWaiter = Waiter::CreateInPlace(&hasWorkWaiters[addedCount], notifier);
+                if (!mReEntrantContexts[addedCount]->GetHasWorkCondition().AddWaiter(hasWorkWaiter))
+                    break;
+            }
+
+            if (addedCount == contextCount && readySemaphore.Wait(deadline.GetRemaining(waitMode).timeout))
+                unconsumedCount--;
+
+            std::uint32_t inFlightCount = 0;
+            for (std::size_t i = 0; i < addedCount; ++i)
+                if (!mReEntrantContexts[i]->GetHasWorkCondition().RemoveWaiter(&hasWorkWaiters[i]))
+                    inFlightCount++;
+
+            if (inFlightCount != 0)
+            {
+                // Exactly one of the callbacks posts. Let them all finish before the waiters are reused.
+                while (slot.doneCount.Load(MEMORY_ORDER_ACQUIRE) != inFlightCount)
+                    ThreadYield();
+
+                unconsumedCount++;
+            }
+
+            // Don't let stale posts cut the next sleep short
+            for (; unconsumedCount > 0; --unconsumedCount)
+                readySemaphore.Wait();
+        }
+        mCooperativeDepth--;
+
+        // Notified unless the waiter can still be removed
+        bool const notified = ready || !waitable.RemoveWaiter(waiter);
+        if (notified && unconsumedCount == 0)
+            readySemaphore.Wait();
+
+        waiter->Destroy();
+        return notified;
+    }
+
+    CRUNCH_ALWAYS_INLINE bool WaitForAll(IWaitable** waitables, std::size_t count, WaitMode waitMode)
+    {
+        return WaitForAllImpl(mWaitSemaphore, waitables, count, waitMode);
     }
 
     WaitForAnyResult WaitForAny(IWaitable** waitables, std::size_t count, WaitMode waitMode)
@@ -522,12 +805,18 @@ stopped:
     }
 
 private:
+    // Bounds stack growth from cooperative waits inside work run by cooperative waits. Deeper waits block.
+    static std::uint32_t const MAX_COOPERATIVE_DEPTH = 8;
+
     MetaScheduler& mOwner;
     std::uint32_t mRefCount;
     Detail::SystemSemaphore mWaitSemaphore;
     Waiter* mWaiter;
     std::function<void ()> mWaiterDestroyer;
 
+    std::vector<ISchedulerContext*> mReEntrantContexts;
+    std::uint32_t mCooperativeDepth;
+
     // Detail::SystemMutex mStateLock;
     // Detail::SystemSemaphore mStateChanged;
 };
@@ -578,29 +867,29 @@ MetaScheduler::Context& MetaScheduler::AcquireContext()
     return *tCurrentContext;
 }
 
-void WaitFor(IWaitable& waitable, WaitMode waitMode)
+bool WaitFor(IWaitable& waitable, WaitMode waitMode)
 {
     if (MetaScheduler::tCurrentContext)
     {
-        MetaScheduler::tCurrentContext->WaitFor(waitable, waitMode);
+        return MetaScheduler::tCurrentContext->WaitFor(waitable, waitMode);
     }
     else
     {
         Detail::SystemSemaphore waitSemaphore(0);
-        WaitForImpl(waitSemaphore, waitable, waitMode);
+        return WaitForImpl(waitSemaphore, waitable, waitMode);
     }
 }
 
-void WaitForAll(IWaitable** waitables, std::size_t count, WaitMode waitMode)
+bool WaitForAll(IWaitable** waitables, std::size_t count, WaitMode waitMode)
 {
     if (MetaScheduler::tCurrentContext)
     {
-        MetaScheduler::tCurrentContext->WaitForAll(waitables, count, waitMode);
+        return MetaScheduler::tCurrentContext->WaitForAll(waitables, count, waitMode);
     }
     else
     {
         Detail::SystemSemaphore waitSemaphore(0);
-        WaitForAllImpl(waitSemaphore, waitables, count, waitMode);
+        return WaitForAllImpl(waitSemaphore, waitables, count, waitMode);
     }
 }
 
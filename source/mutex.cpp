@@ -5,11 +5,15 @@
 #include "crunch/concurrency/exponential_backoff.hpp"
 #include "crunch/concurrency/mutex.hpp"
 
+#include <algorithm>
+
 namespace Crunch { namespace Concurrency {
 
-Mutex::Mutex(std::uint32_t spinCount)
+Mutex::Mutex(std::uint32_t spinCount, Mode mode)
     : mWaiters(MUTEX_FREE_BIT)
     , mSpinCount(spinCount)
+    , mMode(mode)
+    , mSpinBudget(MIN_ADAPTIVE_SPIN_COUNT, MEMORY_ORDER_RELAXED)
 {}
 
 void Mutex::Lock()
@@ -17,20 +21,49 @@ void Mutex::Lock()
     std::uint64_t head = MUTEX_FREE_BIT;
     if (mWaiters.CompareAndSwap(head, 0))
         return;
-    
-    std::uint32_t spinLeft = mSpinCount;
-    while (spinLeft--)
+
+    if (mSpinCount != ADAPTIVE_SPIN)
+    {
+        if (SpinLock(mSpinCount) != mSpinCount)
+            return;
+    }
+    else
     {
-        head = mWaiters.Load(MEMORY_ORDER_RELAXED);
+        // Spin for up to twice the budget so it can grow as well as shrink. Racing updates may lose a sample,
+        // which doesn't matter for an estimate.
+        std::uint32_t const budget = mSpinBudget.Load(MEMORY_ORDER_RELAXED);
+        std::uint32_t const maxSpinCount = std::min(budget * 2 + MIN_ADAPTIVE_SPIN_COUNT, MAX_ADAPTIVE_SPIN_COUNT);
+        std::uint32_t const spinCount = SpinLock(maxSpinCount);
+        bool const acquired = spinCount != maxSpinCount;
+
+        // The budget shares a cache line with the lock word that other threads are spinning on, so only store it
+        // when the estimate moves
+        std::int32_t const sample = acquired ? static_cast<std::int32_t>(spinCount) : 0;
+        std::int32_t const delta = (sample - static_cast<std::int32_t>(budget)) / 8;
+        if (delta != 0)
+            mSpinBudget.Store(budget + static_cast<std::uint32_t>(delta), MEMORY_ORDER_RELAXED);
+
+        if (acquired)
+            return;
+    }
+
+    WaitFor(*this);
+}
+
+std::uint32_t Mutex::SpinLock(std::uint32_t spinCount)
+{
+    for (std::uint32_t i = 0; i < spinCount; ++i)
+    {
+        std::uint64_t head = mWaiters.Load(MEMORY_ORDER_RELAXED);
         if (head == MUTEX_FREE_BIT)
         {
             if (mWaiters.CompareAndSwap(head, 0))
-                return;
+                return i;
         }
         CRUNCH_PAUSE();
     }
 
-    WaitFor(*this);
+    return spinCount;
 }
 
 void Mutex::Unlock()
@@ -58,6 +91,12 @@ void Mutex::Unlock()
             // Wait for lock release.
             head = mWaiters.Load(MEMORY_ORDER_RELAXED);
         }
+        else if (mMode == MODE_FAIR && headPtr->next != nullptr)
+        {
+            // Lock is never released while anyone is waiting, so new lockers can't get ahead of the oldest waiter
+            if (TryHandOffToOldest(head))
+                return;
+        }
         else 
         {
             // Try to pop first waiter off list and signal
@@ -76,6 +115,26 @@ void Mutex::Unlock()
     }
 }
 
+bool Mutex::TryHandOffToOldest(std::uint64_t& head)
+{
+    // Lock list from concurrent removal. New waiters may still be pushed in front of the locked head.
+    if (!mWaiters.CompareAndSwap(head, (head | Detail::WaiterList::LOCK_BIT) + Detail::WaiterList::ABA_ADDEND))
+        return false;
+
+    Waiter* previous = Detail::WaiterList::GetPointer(head);
+    Waiter* oldest = previous->next;
+    while (oldest->next != nullptr)
+    {
+        previous = oldest;
+        oldest = oldest->next;
+    }
+
+    previous->next = nullptr;
+    mWaiters.Unlock();
+    oldest->Notify();
+    return true;
+}
+
 bool Mutex::IsLocked() const
 {
     return mWaiters.Load(MEMORY_ORDER_RELAXED) != MUTEX_FREE_BIT;
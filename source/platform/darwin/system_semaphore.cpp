@@ -38,6 +38,47 @@ void SystemSemaphore::Wait()
         CRUNCH_ASSERT_ALWAYS(semaphore_wait(mSemaphore) == KERN_SUCCESS);
 }
 
+bool SystemSemaphore::Wait(Duration timeout)
+{
+    if (timeout.IsPosInfinity())
+    {
+        Wait();
+        return true;
+    }
+
+    if (mCount.Decrement() > 0)
+        return true;
+
+    std::int64_t const NanosecondsPerSecond = 1000000000;
+    std::int64_t const nanoseconds = timeout.IsNegative() ? 0 : timeout.GetTotalNanoseconds();
+    mach_timespec_t const tsTimeout =
+    {
+        static_cast<unsigned int>(nanoseconds / NanosecondsPerSecond),
+        static_cast<clock_res_t>(nanoseconds % NanosecondsPerSecond)
+    };
+
+    kern_return_t const result = semaphore_timedwait(mSemaphore, tsTimeout);
+    if (result == KERN_SUCCESS)
+        return true;
+
+    CRUNCH_ASSERT_ALWAYS(result == KERN_OPERATION_TIMED_OUT);
+    return Withdraw();
+}
+
+bool SystemSemaphore::Withdraw()
+{
+    // Give up our place, unless a Post has counted us in the meantime and signaled the semaphore on our behalf
+    std::int32_t count = mCount.Load(MEMORY_ORDER_RELAXED);
+    while (count < 0)
+    {
+        if (mCount.CompareAndSwap(count, count + 1))
+            return false;
+    }
+
+    CRUNCH_ASSERT_ALWAYS(semaphore_wait(mSemaphore) == KERN_SUCCESS);
+    return true;
+}
+
 bool SystemSemaphore::TryWait()
 {
     std::int32_t count = mCount.Load(MEMORY_ORDER_RELAXED);
@@ -0,0 +1,108 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#ifndef CRUNCH_CONCURRENCY_PLATFORM_LINUX_FUTEX_HPP
+#define CRUNCH_CONCURRENCY_PLATFORM_LINUX_FUTEX_HPP
+
+#include "crunch/base/duration.hpp"
+#include "crunch/concurrency/atomic.hpp"
+
+#include <cerrno>
+#include <cstdint>
+#include <climits>
+#include <ctime>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace Crunch { namespace Concurrency { namespace Platform {
+
+// Process private futex operations on a 32 bit word, typically the storage of an Atomic. The kernel only ever compares
+// the word, so the Atomic remains the sole owner of its value.
+
+inline int* GetFutexAddress(void const volatile* address)
+{
+    return const_cast<int*>(static_cast<int const volatile*>(address));
+}
+
+template<typename T>
+int* GetFutexAddress(Atomic<T>& word)
+{
+    static_assert(sizeof(Atomic<T>) == sizeof(int), "Futex word must be 32 bits");
+    return GetFutexAddress(static_cast<void const volatile*>(&word));
+}
+
+/// Sleep while word equals expected. May return spuriously.
+inline void FutexWait(int* address, int expected)
+{
+    syscall(SYS_futex, address, FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+}
+
+template<typename T>
+void FutexWait(Atomic<T>& word, T expected)
+{
+    FutexWait(GetFutexAddress(word), static_cast<int>(expected));
+}
+
+/// Sleep while word equals expected, for at most timeout. May return spuriously.
+/// \return false if timed out
+inline bool FutexWait(int* address, int expected, Duration timeout)
+{
+    if (timeout.IsNegative())
+        return false;
+
+    std::int64_t const NanosecondsPerSecond = 1000000000;
+    std::int64_t const totalNs = timeout.GetTotalNanoseconds();
+    timespec const tsTimeout =
+    {
+        static_cast<time_t>(totalNs / NanosecondsPerSecond),
+        static_cast<long>(totalNs % NanosecondsPerSecond)
+    };
+
+    // Relative timeout for FUTEX_WAIT
+    return syscall(SYS_futex, address, FUTEX_WAIT_PRIVATE, expected, &tsTimeout, nullptr, 0) != -1 || errno != ETIMEDOUT;
+}
+
+template<typename T>
+bool FutexWait(Atomic<T>& word, T expected, Duration timeout)
+{
+    return FutexWait(GetFutexAddress(word), static_cast<int>(expected), timeout);
+}
+
+/// Wake up to count threads sleeping on word
+inline void FutexWake(int* address, int count)
+{
+    syscall(SYS_futex, address, FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+}
+
+template<typename T>
+void FutexWake(Atomic<T>& word, int count)
+{
+    FutexWake(GetFutexAddress(word), count);
+}
+
+template<typename T>
+void FutexWakeAll(Atomic<T>& word)
+{
+    FutexWake(word, INT_MAX);
+}
+
+/// Wake one thread sleeping on word and move the rest to sleep on target, provided word still equals expected
+/// \return false if word had changed, in which case nothing was done
+template<typename T, typename U>
+bool FutexRequeue(Atomic<T>& word, T expected, Atomic<U>& target)
+{
+    return syscall(
+        SYS_futex,
+        GetFutexAddress(word),
+        FUTEX_CMP_REQUEUE_PRIVATE,
+        1,
+        reinterpret_cast<void*>(static_cast<std::uintptr_t>(INT_MAX)),
+        GetFutexAddress(target),
+        static_cast<int>(expected)) != -1;
+}
+
+}}}
+
+#endif
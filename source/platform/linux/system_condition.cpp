@@ -4,31 +4,47 @@
 #include "crunch/concurrency/detail/system_condition.hpp"
 #include "crunch/base/assert.hpp"
 
+#include "futex.hpp"
+
 namespace Crunch { namespace Concurrency { namespace Detail {
 
 SystemCondition::SystemCondition()
-{
-    CRUNCH_ASSERT_ALWAYS(pthread_cond_init(&mCondition, nullptr) == 0);
-}
+    : mSequence(0)
+    , mMutex(nullptr)
+{}
 
 SystemCondition::~SystemCondition()
-{
-    pthread_cond_destroy(&mCondition);
-}
+{}
 
 void SystemCondition::Wait(SystemMutex& lock)
 {
-    CRUNCH_ASSERT_ALWAYS(pthread_cond_wait(&mCondition, &lock.mMutex) == 0);
+    mMutex.Store(&lock, MEMORY_ORDER_RELAXED);
+
+    // Any wake after this point changes the sequence, so the futex wait returns immediately if it was missed
+    std::uint32_t const sequence = mSequence.Load(MEMORY_ORDER_RELAXED);
+    lock.Unlock();
+    Platform::FutexWait(mSequence, sequence);
+
+    // Reacquire as contended. Waiters may have been requeued onto the mutex, and each one woken must pass the wake on
+    // to the next when unlocking.
+    lock.LockContended(lock.mState.Swap(SystemMutex::CONTENDED, MEMORY_ORDER_ACQUIRE));
 }
 
 void SystemCondition::WakeOne()
 {
-    CRUNCH_ASSERT_ALWAYS(pthread_cond_signal(&mCondition) == 0);
+    mSequence.Increment(MEMORY_ORDER_RELEASE);
+    Platform::FutexWake(mSequence, 1);
 }
 
 void SystemCondition::WakeAll()
 {
-    CRUNCH_ASSERT_ALWAYS(pthread_cond_broadcast(&mCondition) == 0);
+    std::uint32_t const sequence = mSequence.Increment(MEMORY_ORDER_RELEASE) + 1;
+
+    // Wake one and move the rest onto the mutex, rather than waking all of them only to have them contend for it.
+    // The woken waiter hands the wake on when it unlocks.
+    SystemMutex* const mutex = mMutex.Load(MEMORY_ORDER_RELAXED);
+    if (mutex == nullptr || !Platform::FutexRequeue(mSequence, sequence, mutex->mState))
+        Platform::FutexWakeAll(mSequence);
 }
 
 }}}
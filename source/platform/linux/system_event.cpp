@@ -4,66 +4,52 @@
 #include "crunch/concurrency/detail/system_event.hpp"
 #include "crunch/base/assert.hpp"
 
+#include "futex.hpp"
+
 namespace Crunch { namespace Concurrency { namespace Detail {
 
-SystemEvent::SystemEvent(bool initialState)
-    : mState(initialState)
+namespace
 {
-    int mutexResult = pthread_mutex_init(&mMutex, nullptr);
-    CRUNCH_ASSERT_ALWAYS(mutexResult == 0);
-
-    int conditionResult = pthread_cond_init(&mCondition, nullptr);
-    CRUNCH_ASSERT_ALWAYS(conditionResult == 0);
+    std::uint32_t const UNSET = 0;
+    std::uint32_t const SET = 1;
+    std::uint32_t const UNSET_WITH_SLEEPERS = 2;
 }
 
+SystemEvent::SystemEvent(bool initialState)
+    : mState(initialState ? SET : UNSET)
+{}
+
 SystemEvent::~SystemEvent()
-{
-    pthread_cond_destroy(&mCondition);
-    pthread_mutex_destroy(&mMutex);
-}
+{}
 
 void SystemEvent::Set()
 {
-    if (mState)
+    if (mState.Load(MEMORY_ORDER_RELAXED) == SET)
         return;
 
-    int lockResult = pthread_mutex_lock(&mMutex);
-    CRUNCH_ASSERT_ALWAYS(lockResult == 0);
-
-    if (!mState)
-    {
-        mState = true;
-        int broadcastResult = pthread_cond_broadcast(&mCondition);
-        CRUNCH_ASSERT_ALWAYS(broadcastResult == 0);
-    }
-
-    int unlockResult = pthread_mutex_unlock(&mMutex);
-    CRUNCH_ASSERT_ALWAYS(unlockResult == 0);
+    if (mState.Swap(SET, MEMORY_ORDER_RELEASE) == UNSET_WITH_SLEEPERS)
+        Platform::FutexWakeAll(mState);
 }
 
 void SystemEvent::Reset()
 {
-    mState = false;
+    // Sleepers only exist while unset, so there's nothing to do unless set
+    std::uint32_t state = SET;
+    mState.CompareAndSwap(state, UNSET, MEMORY_ORDER_RELAXED);
 }
 
 void SystemEvent::Wait()
 {
-    if (mState)
-        return;
-
-    int lockResult = pthread_mutex_lock(&mMutex);
-    CRUNCH_ASSERT_ALWAYS(lockResult == 0);
-    
-    while (!mState)
+    std::uint32_t state = mState.Load(MEMORY_ORDER_ACQUIRE);
+    while (state != SET)
     {
-        int waitResult = pthread_cond_wait(&mCondition, &mMutex);
-        CRUNCH_ASSERT_ALWAYS(waitResult == 0);
-    }
+        // Announce sleeper so Set knows to make the syscall
+        if (state == UNSET && !mState.CompareAndSwap(state, UNSET_WITH_SLEEPERS, MEMORY_ORDER_ACQUIRE))
+            continue;
 
-    int unlockResult = pthread_mutex_unlock(&mMutex);
-    CRUNCH_ASSERT_ALWAYS(unlockResult == 0);
+        Platform::FutexWait(mState, UNSET_WITH_SLEEPERS);
+        state = mState.Load(MEMORY_ORDER_ACQUIRE);
+    }
 }
 
-
-
 }}}
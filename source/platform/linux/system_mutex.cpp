@@ -4,35 +4,54 @@
 #include "crunch/concurrency/detail/system_mutex.hpp"
 #include "crunch/base/assert.hpp"
 
+#include "futex.hpp"
+
 namespace Crunch { namespace Concurrency { namespace Detail {
 
+// Reference: Drepper. Futexes Are Tricky. 2011.
+
 SystemMutex::SystemMutex()
-{
-    int result = pthread_mutex_init(&mMutex, nullptr);
-    CRUNCH_ASSERT_ALWAYS(result == 0);
-}
+    : mState(UNLOCKED)
+{}
 
 SystemMutex::~SystemMutex()
 {
-    int result = pthread_mutex_destroy(&mMutex);
-    CRUNCH_ASSERT_ALWAYS(result == 0);
+    CRUNCH_ASSERT_ALWAYS(mState.Load(MEMORY_ORDER_RELAXED) == UNLOCKED);
 }
 
 bool SystemMutex::TryLock()
 {
-    return pthread_mutex_trylock(&mMutex) == 0;
+    std::uint32_t state = UNLOCKED;
+    return mState.CompareAndSwap(state, LOCKED, MEMORY_ORDER_ACQUIRE);
 }
 
 void SystemMutex::Lock()
 {
-    int result = pthread_mutex_lock(&mMutex);
-    CRUNCH_ASSERT_ALWAYS(result == 0);
+    std::uint32_t state = UNLOCKED;
+    if (mState.CompareAndSwap(state, LOCKED, MEMORY_ORDER_ACQUIRE))
+        return;
+
+    if (state != CONTENDED)
+        state = mState.Swap(CONTENDED, MEMORY_ORDER_ACQUIRE);
+
+    LockContended(state);
+}
+
+void SystemMutex::LockContended(std::uint32_t state)
+{
+    // Marked contended so the owner wakes someone on unlock. Holding the lock in this state is conservative, as there
+    // is no telling if other threads are still sleeping.
+    while (state != UNLOCKED)
+    {
+        Platform::FutexWait(mState, CONTENDED);
+        state = mState.Swap(CONTENDED, MEMORY_ORDER_ACQUIRE);
+    }
 }
 
 void SystemMutex::Unlock()
 {
-    int result = pthread_mutex_unlock(&mMutex);
-    CRUNCH_ASSERT_ALWAYS(result == 0);
+    if (mState.Swap(UNLOCKED, MEMORY_ORDER_RELEASE) == CONTENDED)
+        Platform::FutexWake(mState, 1);
 }
 
 }}}
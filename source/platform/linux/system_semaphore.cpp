@@ -3,32 +3,124 @@
 
 #include "crunch/concurrency/detail/system_semaphore.hpp"
 #include "crunch/base/assert.hpp"
+#include "crunch/base/high_frequency_timer.hpp"
+
+#include "futex.hpp"
 
 namespace Crunch { namespace Concurrency { namespace Detail {
 
-SystemSemaphore::SystemSemaphore(std::uint32_t initialCount)
+namespace
 {
-    CRUNCH_ASSERT_ALWAYS(sem_init(&mSemaphore, 0, initialCount) == 0);
+    // The futex word holds the count shifted up by one, with the low bit flagging that sleepers may be present. Post
+    // must not touch the semaphore after its increment, since a waiter may then return and destroy it, so the decision
+    // to wake is made from the value returned by the increment alone.
+    std::uint32_t const HasSleepersFlag = 1;
+    std::uint32_t const CountOne = 2;
 }
 
+SystemSemaphore::SystemSemaphore(std::uint32_t initialCount)
+    : mValue(initialCount * CountOne)
+    , mSleeperCount(0)
+{}
+
 SystemSemaphore::~SystemSemaphore()
 {
-    sem_destroy(&mSemaphore);
+    CRUNCH_ASSERT(mSleeperCount.Load(MEMORY_ORDER_RELAXED) == 0);
 }
 
 void SystemSemaphore::Post()
 {
-    CRUNCH_ASSERT_ALWAYS(sem_post(&mSemaphore) == 0);
+    if (mValue.Add(CountOne) & HasSleepersFlag)
+        Platform::FutexWake(mValue, 1);
 }
 
 void SystemSemaphore::Wait()
 {
-    CRUNCH_ASSERT_ALWAYS(sem_wait(&mSemaphore) == 0);
+    if (TryWait())
+        return;
+
+    mSleeperCount.Increment();
+    while (!TryWaitOrSleep())
+        Platform::FutexWait(mValue, HasSleepersFlag);
+    RemoveSleeper();
+}
+
+bool SystemSemaphore::Wait(Duration timeout)
+{
+    if (TryWait())
+        return true;
+
+    if (timeout.IsPosInfinity())
+    {
+        Wait();
+        return true;
+    }
+
+    HighFrequencyTimer const timer;
+    HighFrequencyTimer::SampleType const start = timer.Sample();
+
+    bool acquired = false;
+    mSleeperCount.Increment();
+    for (;;)
+    {
+        if (TryWaitOrSleep())
+        {
+            acquired = true;
+            break;
+        }
+
+        Duration const remaining = timeout - timer.GetElapsedTime(start, timer.Sample());
+        if (remaining <= Duration::Zero)
+            break;
+
+        Platform::FutexWait(mValue, HasSleepersFlag, remaining);
+    }
+    RemoveSleeper();
+
+    return acquired;
 }
 
 bool SystemSemaphore::TryWait()
 {
-    return sem_trywait(&mSemaphore) == 0;
+    std::uint32_t value = mValue.Load(MEMORY_ORDER_RELAXED);
+    for (;;)
+    {
+        if (value < CountOne)
+            return false;
+
+        if (mValue.CompareAndSwap(value, value - CountOne))
+            return true;
+    }
+}
+
+bool SystemSemaphore::TryWaitOrSleep()
+{
+    std::uint32_t value = mValue.Load(MEMORY_ORDER_RELAXED);
+    for (;;)
+    {
+        if (value >= CountOne)
+        {
+            if (mValue.CompareAndSwap(value, value - CountOne))
+                return true;
+        }
+        else if (value == HasSleepersFlag || mValue.CompareAndSwap(value, HasSleepersFlag))
+        {
+            // Count is zero and the flag is set, so Post will wake us
+            return false;
+        }
+    }
+}
+
+void SystemSemaphore::RemoveSleeper()
+{
+    if (mSleeperCount.Decrement() != 1)
+        return;
+
+    // Last sleeper out clears the flag so Post can skip the kernel again. A sleeper registering concurrently may
+    // already have gone to sleep on the flagged value, so if any showed up, wake them all to flag the word afresh.
+    mValue.And(~HasSleepersFlag);
+    if (mSleeperCount.Load() != 0)
+        Platform::FutexWakeAll(mValue);
 }
 
 }}}
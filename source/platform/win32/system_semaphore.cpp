@@ -4,6 +4,7 @@
 #include "crunch/concurrency/detail/system_semaphore.hpp"
 #include "crunch/base/assert.hpp"
 
+#include <algorithm>
 #include <limits>
 
 #include <windows.h>
@@ -32,6 +33,42 @@ void SystemSemaphore::Wait()
         CRUNCH_ASSERT_ALWAYS(::WaitForSingleObject(mSemaphore, INFINITE) == WAIT_OBJECT_0);
 }
 
+bool SystemSemaphore::Wait(Duration timeout)
+{
+    if (timeout.IsPosInfinity())
+    {
+        Wait();
+        return true;
+    }
+
+    if (mCount.Decrement() > 0)
+        return true;
+
+    // Round up so we don't wake before the timeout has elapsed
+    std::int64_t const nanoseconds = timeout.IsNegative() ? 0 : timeout.GetTotalNanoseconds();
+    std::int64_t const milliseconds = std::min<std::int64_t>((nanoseconds + 999999) / 1000000, INFINITE - 1);
+    DWORD const result = ::WaitForSingleObject(mSemaphore, static_cast<DWORD>(milliseconds));
+    if (result == WAIT_OBJECT_0)
+        return true;
+
+    CRUNCH_ASSERT_ALWAYS(result == WAIT_TIMEOUT);
+    return Withdraw();
+}
+
+bool SystemSemaphore::Withdraw()
+{
+    // Give up our place, unless a Post has counted us in the meantime and released the semaphore on our behalf
+    std::int32_t count = mCount.Load(MEMORY_ORDER_RELAXED);
+    while (count < 0)
+    {
+        if (mCount.CompareAndSwap(count, count + 1))
+            return false;
+    }
+
+    CRUNCH_ASSERT_ALWAYS(::WaitForSingleObject(mSemaphore, INFINITE) == WAIT_OBJECT_0);
+    return true;
+}
+
 bool SystemSemaphore::TryWait()
 {
     std::int32_t count = mCount.Load(MEMORY_ORDER_RELAXED);
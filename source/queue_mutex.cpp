@@ -0,0 +1,264 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#include "crunch/concurrency/queue_mutex.hpp"
+
+#include "crunch/base/assert.hpp"
+#include "crunch/concurrency/thread_local.hpp"
+#include "crunch/concurrency/yield.hpp"
+#include "crunch/concurrency/detail/cache_line.hpp"
+#include "crunch/concurrency/detail/system_mutex.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+namespace Crunch { namespace Concurrency {
+
+struct Detail::QueueMutexNode
+{
+    static std::int32_t const WAITING = 0;
+    static std::int32_t const SLEEPING = 1;
+    static std::int32_t const GRANTED = 2;
+    static std::int32_t const ABANDONED = 3;
+
+    // Successor in the queue while queued, and free list link otherwise
+    Atomic<QueueMutexNode*> next;
+    Atomic<std::int32_t> state;
+
+    // Notified on handoff if set. Otherwise a thread in Lock is waiting on state.
+    Waiter* waiter;
+};
+
+namespace
+{
+    typedef Detail::QueueMutexNode Node;
+    typedef Detail::CacheLineAligned<Node> AlignedNode;
+
+    /// Nodes are allocated in chunks and recycled through a free list per thread, as for waiters. Nodes cached by
+    /// exiting threads are handed back to a shared list. Memory is never released before exit, so a late wakeup call
+    /// on the state of a recycled node is harmless.
+    class NodeAllocator
+    {
+    public:
+        NodeAllocator()
+            : mFreeNodes(nullptr)
+        {}
+
+        ~NodeAllocator()
+        {
+            std::for_each(mAllocations.begin(), mAllocations.end(), [] (void* allocation) { std::free(allocation); });
+        }
+
+        /// \return Up to CHUNK_SIZE nodes linked through next, taken from the shared list if it has any
+        Node* AllocateChunk()
+        {
+            {
+                Detail::SystemMutex::ScopedLock lock(mAllocationsLock);
+                if (Node* const head = mFreeNodes)
+                {
+                    Node* last = head;
+                    for (std::uint32_t i = 1; i < CHUNK_SIZE && last->next.Load(MEMORY_ORDER_RELAXED) != nullptr; ++i)
+                        last = last->next.Load(MEMORY_ORDER_RELAXED);
+
+                    mFreeNodes = last->next.Load(MEMORY_ORDER_RELAXED);
+                    last->next.Store(nullptr, MEMORY_ORDER_RELAXED);
+                    return head;
+                }
+            }
+
+            void* allocation = std::malloc(sizeof(AlignedNode) * CHUNK_SIZE + CRUNCH_CACHE_LINE_SIZE);
+            {
+                Detail::SystemMutex::ScopedLock lock(mAllocationsLock);
+                mAllocations.push_back(allocation);
+            }
+
+            std::uintptr_t const aligned =
+                (reinterpret_cast<std::uintptr_t>(allocation) + CRUNCH_CACHE_LINE_SIZE - 1) &
+                ~std::uintptr_t(CRUNCH_CACHE_LINE_SIZE - 1);
+
+            AlignedNode* nodes = reinterpret_cast<AlignedNode*>(aligned);
+            for (std::uint32_t i = 0; i < CHUNK_SIZE; ++i)
+            {
+                Node* node = new (&nodes[i].value) Node();
+                node->next.Store(i + 1 < CHUNK_SIZE ? &nodes[i + 1].value : nullptr, MEMORY_ORDER_RELAXED);
+            }
+
+            return &nodes[0].value;
+        }
+
+        /// \param nodes Non-empty list of nodes linked through next
+        void FreeList(Node* nodes)
+        {
+            Node* last = nodes;
+            while (Node* const next = last->next.Load(MEMORY_ORDER_RELAXED))
+                last = next;
+
+            Detail::SystemMutex::ScopedLock lock(mAllocationsLock);
+            last->next.Store(mFreeNodes, MEMORY_ORDER_RELAXED);
+            mFreeNodes = nodes;
+        }
+
+    private:
+        static std::uint32_t const CHUNK_SIZE = 16;
+
+        Detail::SystemMutex mAllocationsLock;
+        std::vector<void*> mAllocations;
+        Node* mFreeNodes;
+    };
+
+    NodeAllocator gNodeAllocator;
+
+    CRUNCH_THREAD_LOCAL Node* tNodeFreeList = nullptr;
+
+    Node* AllocateNode(Waiter* waiter)
+    {
+        Node* node = tNodeFreeList;
+        if (node == nullptr)
+            node = gNodeAllocator.AllocateChunk();
+
+        tNodeFreeList = node->next.Load(MEMORY_ORDER_RELAXED);
+
+        node->next.Store(nullptr, MEMORY_ORDER_RELAXED);
+        node->state.Store(Node::WAITING, MEMORY_ORDER_RELAXED);
+        node->waiter = waiter;
+        return node;
+    }
+
+    void FreeNode(Node* node)
+    {
+        node->next.Store(tNodeFreeList, MEMORY_ORDER_RELAXED);
+        tNodeFreeList = node;
+    }
+}
+
+void Detail::ReleaseQueueMutexNodeCache()
+{
+    if (Node* const nodes = tNodeFreeList)
+    {
+        tNodeFreeList = nullptr;
+        gNodeAllocator.FreeList(nodes);
+    }
+}
+
+QueueMutex::QueueMutex(std::uint32_t spinCount)
+    : mTail(nullptr, MEMORY_ORDER_RELAXED)
+    , mHolder(nullptr)
+    , mSpinCount(spinCount)
+{}
+
+bool QueueMutex::Enqueue(Node* node)
+{
+    Node* const predecessor = mTail.Swap(node, MEMORY_ORDER_ACQ_REL);
+    if (predecessor == nullptr)
+    {
+        node->state.Store(Node::GRANTED, MEMORY_ORDER_RELAXED);
+        mHolder = node;
+        return false;
+    }
+
+    predecessor->next.Store(node, MEMORY_ORDER_RELEASE);
+    return true;
+}
+
+void QueueMutex::Lock()
+{
+    Node* const node = AllocateNode(nullptr);
+    if (!Enqueue(node))
+        return;
+
+    for (std::uint32_t i = 0; i < mSpinCount; ++i)
+    {
+        if (node->state.Load(MEMORY_ORDER_ACQUIRE) == Node::GRANTED)
+            return;
+
+        CRUNCH_PAUSE();
+    }
+
+    std::int32_t state = Node::WAITING;
+    if (!node->state.CompareAndSwap(state, Node::SLEEPING, MEMORY_ORDER_ACQUIRE))
+        return;
+
+    while (node->state.Load(MEMORY_ORDER_ACQUIRE) == Node::SLEEPING)
+        node->state.Wait(Node::SLEEPING, MEMORY_ORDER_ACQUIRE);
+}
+
+void QueueMutex::Unlock()
+{
+    CRUNCH_ASSERT_MSG(mHolder != nullptr, "Attempting to release unlocked mutex");
+
+    Node* node = mHolder;
+    for (;;)
+    {
+        Node* successor = node->next.Load(MEMORY_ORDER_ACQUIRE);
+        if (successor == nullptr)
+        {
+            mHolder = nullptr;
+            Node* expected = node;
+            if (mTail.CompareAndSwap(expected, nullptr, MEMORY_ORDER_RELEASE))
+            {
+                FreeNode(node);
+                return;
+            }
+
+            // Successor has swapped itself in as tail, but not yet linked
+            while ((successor = node->next.Load(MEMORY_ORDER_ACQUIRE)) == nullptr)
+                CRUNCH_PAUSE();
+        }
+
+        FreeNode(node);
+        mHolder = successor;
+
+        Waiter* const waiter = successor->waiter;
+        if (waiter == nullptr)
+        {
+            if (successor->state.Swap(Node::GRANTED, MEMORY_ORDER_RELEASE) == Node::SLEEPING)
+                successor->state.NotifyOne();
+
+            return;
+        }
+
+        std::int32_t state = Node::WAITING;
+        if (successor->state.CompareAndSwap(state, Node::GRANTED, MEMORY_ORDER_ACQ_REL))
+        {
+            waiter->Notify();
+            return;
+        }
+
+        // Waiter was withdrawn, so release on its behalf
+        CRUNCH_ASSERT(state == Node::ABANDONED);
+        node = successor;
+    }
+}
+
+bool QueueMutex::IsLocked() const
+{
+    return mTail.Load(MEMORY_ORDER_RELAXED) != nullptr;
+}
+
+bool QueueMutex::AddWaiter(Waiter* waiter)
+{
+    // Node is found through the waiter's list link, which is ours while the waiter is added. Set before the waiter
+    // can be notified.
+    Node* const node = AllocateNode(waiter);
+    waiter->next = reinterpret_cast<Waiter*>(node);
+    return Enqueue(node);
+}
+
+bool QueueMutex::RemoveWaiter(Waiter* waiter)
+{
+    Node* const node = reinterpret_cast<Node*>(waiter->next);
+
+    // Fails if the lock has been handed to the waiter
+    std::int32_t state = Node::WAITING;
+    return node->state.CompareAndSwap(state, Node::ABANDONED, MEMORY_ORDER_ACQ_REL);
+}
+
+bool QueueMutex::IsOrderDependent() const
+{
+    return true;
+}
+
+}}
@@ -0,0 +1,285 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#include "crunch/concurrency/read_write_mutex.hpp"
+
+#include "crunch/base/assert.hpp"
+#include "crunch/concurrency/exponential_backoff.hpp"
+#include "crunch/concurrency/thread_local.hpp"
+#include "crunch/concurrency/waiter_utility.hpp"
+
+namespace Crunch { namespace Concurrency {
+
+namespace
+{
+    Atomic<std::uint32_t> gNextReaderSlot(0, MEMORY_ORDER_RELAXED);
+
+    // Slot index plus one, or zero if not yet assigned
+    CRUNCH_THREAD_LOCAL std::uint32_t tReaderSlot = 0;
+
+    std::uint32_t CountWaiters(Waiter* head)
+    {
+        std::uint32_t count = 0;
+        for (; head != nullptr; head = head->next)
+            count++;
+        return count;
+    }
+}
+
+ReadWriteMutex::ReadWriteMutex()
+    : mWriters(0)
+    , mReaders(0)
+    , mDrainWaiter(0)
+    , mShared(*this)
+{
+    for (std::uint32_t i = 0; i < READER_SLOT_COUNT; ++i)
+        mReaderSlots[i].value.Store(0, MEMORY_ORDER_RELAXED);
+}
+
+Atomic<std::uint32_t>& ReadWriteMutex::GetReaderSlot()
+{
+    if (tReaderSlot == 0)
+        tReaderSlot = gNextReaderSlot.Increment(MEMORY_ORDER_RELAXED) % READER_SLOT_COUNT + 1;
+
+    return mReaderSlots[tReaderSlot - 1].value;
+}
+
+std::uint32_t ReadWriteMutex::GetReaderCount() const
+{
+    std::uint32_t count = 0;
+    for (std::uint32_t i = 0; i < READER_SLOT_COUNT; ++i)
+        count += mReaderSlots[i].value.Load();
+    return count;
+}
+
+bool ReadWriteMutex::TryLockShared()
+{
+    // Sequentially consistent increment and load pair with the writer setting its flag and then reading the slots.
+    // Either the writer sees this reader, or this reader sees the writer.
+    Atomic<std::uint32_t>& slot = GetReaderSlot();
+    slot.Increment();
+    if ((mWriters.Load() & WRITER_BIT) == 0)
+        return true;
+
+    slot.Decrement();
+    NotifyIfDrained();
+    return false;
+}
+
+void ReadWriteMutex::LockShared()
+{
+    if (!TryLockShared())
+        WaitFor(mShared);
+}
+
+void ReadWriteMutex::UnlockShared()
+{
+    GetReaderSlot().Decrement();
+    if (mWriters.Load() & WRITER_BIT)
+        NotifyIfDrained();
+}
+
+bool ReadWriteMutex::AddSharedWaiter(Waiter* waiter)
+{
+    ExponentialBackoff backoff;
+    for (;;)
+    {
+        if (TryLockShared())
+            return false;
+
+        // Only queue while blocked, so a leaving writer that unblocks and takes the queue in one step can't miss us
+        std::uint64_t head = mReaders.Load(MEMORY_ORDER_RELAXED);
+        while (head & READERS_BLOCKED_BIT)
+        {
+            waiter->next = Detail::WaiterList::GetPointer(head);
+            std::uint64_t const newHead = Detail::WaiterList::SetPointer(head, waiter) + Detail::WaiterList::ABA_ADDEND;
+            if (mReaders.CompareAndSwap(head, newHead))
+                return true;
+        }
+
+        // Writer is just arriving or leaving
+        backoff.Pause();
+    }
+}
+
+void ReadWriteMutex::NotifyIfDrained()
+{
+    // Load the waiter before counting, so a writer installed later is counted against the readers it admitted
+    std::uint64_t head = mDrainWaiter.Load();
+    Waiter* const waiter = Detail::WaiterList::GetPointer(head);
+    if (waiter == nullptr || GetReaderCount() != 0)
+        return;
+
+    if (mDrainWaiter.CompareAndSwap(head, Detail::WaiterList::SetPointer(head, nullptr) + Detail::WaiterList::ABA_ADDEND))
+        waiter->Notify();
+}
+
+bool ReadWriteMutex::WaitForReaders(Waiter* waiter)
+{
+    if (GetReaderCount() == 0)
+        return false;
+
+    std::uint64_t head = mDrainWaiter.Load(MEMORY_ORDER_RELAXED);
+    CRUNCH_ASSERT_MSG(Detail::WaiterList::GetPointer(head) == nullptr, "Multiple writers waiting for readers");
+
+    std::uint64_t installed = Detail::WaiterList::SetPointer(head, waiter) + Detail::WaiterList::ABA_ADDEND;
+    mDrainWaiter.Store(installed);
+    if (GetReaderCount() != 0)
+        return true;
+
+    // Last reader may have left before seeing the waiter. Take it back unless a reader already did.
+    return !mDrainWaiter.CompareAndSwap(installed, Detail::WaiterList::SetPointer(installed, nullptr) + Detail::WaiterList::ABA_ADDEND);
+}
+
+void ReadWriteMutex::Lock()
+{
+    WaitFor(*this);
+}
+
+void ReadWriteMutex::Unlock()
+{
+    // Unblock and take readers that queued up behind this writer, and admit them before anyone else can take the
+    // write side. New readers spin until the write side is either released or handed to the next writer.
+    ExponentialBackoff backoff;
+    std::uint64_t readersHead = mReaders.Load(MEMORY_ORDER_RELAXED);
+    for (;;)
+    {
+        if ((readersHead & Detail::WaiterList::LOCK_BIT) == 0)
+        {
+            std::uint64_t const newReadersHead =
+                (readersHead & ~(Detail::WaiterList::PTR_MASK | READERS_BLOCKED_BIT)) + Detail::WaiterList::ABA_ADDEND;
+
+            if (mReaders.CompareAndSwap(readersHead, newReadersHead))
+                break;
+        }
+        else
+        {
+            backoff.Pause();
+            readersHead = mReaders.Load(MEMORY_ORDER_RELAXED);
+        }
+    }
+
+    Waiter* const readers = Detail::WaiterList::GetPointer(readersHead);
+    if (readers != nullptr)
+        GetReaderSlot().Add(CountWaiters(readers));
+
+    backoff.Reset();
+    std::uint64_t head = mWriters.Load(MEMORY_ORDER_RELAXED);
+    for (;;)
+    {
+        CRUNCH_ASSERT_MSG((head & WRITER_BIT) != 0, "Attempting to release unlocked mutex");
+
+        Waiter* const headPtr = Detail::WaiterList::GetPointer(head);
+        if (head & Detail::WaiterList::LOCK_BIT)
+        {
+            // Wait for removal to complete
+            head = mWriters.Load(MEMORY_ORDER_RELAXED);
+        }
+        else if (headPtr == nullptr)
+        {
+            if (mWriters.CompareAndSwap(head, (head & ~WRITER_BIT) + Detail::WaiterList::ABA_ADDEND))
+            {
+                NotifyAllWaiters(readers);
+                return;
+            }
+        }
+        else
+        {
+            // Hand write side to next writer, which must let any admitted readers finish first
+            std::uint64_t const newHead = Detail::WaiterList::SetPointer(head, headPtr->next) + Detail::WaiterList::ABA_ADDEND;
+            if (mWriters.CompareAndSwap(head, newHead))
+            {
+                mReaders.Or(READERS_BLOCKED_BIT);
+                NotifyAllWaiters(readers);
+                if (!WaitForReaders(headPtr))
+                    headPtr->Notify();
+
+                return;
+            }
+        }
+
+        backoff.Pause();
+    }
+}
+
+bool ReadWriteMutex::IsWriterActive() const
+{
+    return (mWriters.Load(MEMORY_ORDER_RELAXED) & WRITER_BIT) != 0;
+}
+
+bool ReadWriteMutex::AddWaiter(Waiter* waiter)
+{
+    ExponentialBackoff backoff;
+    std::uint64_t head = mWriters.Load(MEMORY_ORDER_RELAXED);
+    for (;;)
+    {
+        if (head & WRITER_BIT)
+        {
+            waiter->next = Detail::WaiterList::GetPointer(head);
+            std::uint64_t const newHead = Detail::WaiterList::SetPointer(head, waiter) + Detail::WaiterList::ABA_ADDEND;
+            if (mWriters.CompareAndSwap(head, newHead))
+                return true;
+        }
+        else
+        {
+            CRUNCH_ASSERT(Detail::WaiterList::GetPointer(head) == nullptr);
+            if (mWriters.CompareAndSwap(head, (head | WRITER_BIT) + Detail::WaiterList::ABA_ADDEND))
+            {
+                mReaders.Or(READERS_BLOCKED_BIT);
+                return WaitForReaders(waiter);
+            }
+        }
+
+        backoff.Pause();
+    }
+}
+
+bool ReadWriteMutex::RemoveWaiter(Waiter* waiter)
+{
+    // Writer that has the write side and is only waiting for readers gives it up again
+    std::uint64_t drainHead = mDrainWaiter.Load();
+    if (Detail::WaiterList::GetPointer(drainHead) == waiter)
+    {
+        if (mDrainWaiter.CompareAndSwap(drainHead, Detail::WaiterList::SetPointer(drainHead, nullptr) + Detail::WaiterList::ABA_ADDEND))
+        {
+            Unlock();
+            return true;
+        }
+
+        return false;
+    }
+
+    return mWriters.RemoveWaiter(waiter);
+}
+
+bool ReadWriteMutex::IsOrderDependent() const
+{
+    return true;
+}
+
+void ReadWriteMutex::Shared::Lock()
+{
+    mOwner.LockShared();
+}
+
+void ReadWriteMutex::Shared::Unlock()
+{
+    mOwner.UnlockShared();
+}
+
+bool ReadWriteMutex::Shared::AddWaiter(Waiter* waiter)
+{
+    return mOwner.AddSharedWaiter(waiter);
+}
+
+bool ReadWriteMutex::Shared::RemoveWaiter(Waiter* waiter)
+{
+    return mOwner.mReaders.RemoveWaiter(waiter);
+}
+
+bool ReadWriteMutex::Shared::IsOrderDependent() const
+{
+    return true;
+}
+
+}}
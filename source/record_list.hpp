@@ -0,0 +1,86 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#ifndef CRUNCH_CONCURRENCY_SOURCE_RECORD_LIST_HPP
+#define CRUNCH_CONCURRENCY_SOURCE_RECORD_LIST_HPP
+
+#include "crunch/base/noncopyable.hpp"
+#include "crunch/concurrency/atomic.hpp"
+
+#include <cstdint>
+
+namespace Crunch { namespace Concurrency { namespace Detail {
+
+/// Lock-free registry of per thread records for a reclamation domain. Records are only ever added, and are reused by
+/// new threads once released, so the list can be traversed without protection. Record must have an
+/// Atomic<std::uint32_t> inUse, constructed as 1, and a Record* next.
+template<typename Record>
+class RecordList : NonCopyable
+{
+public:
+    RecordList()
+        : mHead(nullptr, MEMORY_ORDER_RELAXED)
+    {}
+
+    /// No other threads may access the records at this point
+    ~RecordList()
+    {
+        Record* record = mHead.Load(MEMORY_ORDER_ACQUIRE);
+        while (record)
+        {
+            Record* const next = record->next;
+            delete record;
+            record = next;
+        }
+    }
+
+    /// Claim a released record, or link in a new one from create if there is none
+    template<typename F>
+    Record* Acquire(F create)
+    {
+        for (Record* record = GetHead(); record; record = record->next)
+        {
+            if (TryAcquire(*record))
+                return record;
+        }
+
+        Record* const record = create();
+        Record* head = mHead.Load(MEMORY_ORDER_RELAXED);
+        for (;;)
+        {
+            record->next = head;
+            if (mHead.CompareAndSwap(head, record, MEMORY_ORDER_RELEASE))
+                return record;
+        }
+    }
+
+    Record* Acquire()
+    {
+        return Acquire([] { return new Record(); });
+    }
+
+    /// Claim a specific record if it has been released
+    static bool TryAcquire(Record& record)
+    {
+        std::uint32_t free = 0;
+        return record.inUse.Load(MEMORY_ORDER_RELAXED) == 0 &&
+            record.inUse.CompareAndSwap(free, 1, MEMORY_ORDER_ACQUIRE);
+    }
+
+    void Release(Record* record)
+    {
+        record->inUse.Store(0, MEMORY_ORDER_RELEASE);
+    }
+
+    Record* GetHead() const
+    {
+        return mHead.Load(MEMORY_ORDER_ACQUIRE);
+    }
+
+private:
+    Atomic<Record*> mHead;
+};
+
+}}}
+
+#endif
@@ -0,0 +1,320 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#include "crunch/concurrency/task_scheduler.hpp"
+
+#include "crunch/base/assert.hpp"
+#include "crunch/concurrency/fence.hpp"
+#include "crunch/concurrency/thread.hpp"
+#include "crunch/concurrency/work_stealing_deque.hpp"
+#include "crunch/concurrency/yield.hpp"
+
+#include <algorithm>
+
+namespace Crunch { namespace Concurrency {
+
+class TaskScheduler::ContextImpl : public ISchedulerContext, NonCopyable
+{
+public:
+    ContextImpl(TaskScheduler& owner, ThreadId threadId, std::uint32_t seed)
+        : mOwner(owner)
+        , mThreadId(threadId)
+        , mRefCount(1)
+        , mRandomState(seed)
+        , mIdle(false)
+    {}
+
+    TaskScheduler& GetOwner()
+    {
+        return mOwner;
+    }
+
+    // Ownership is only changed and inspected under the owner's contexts lock
+
+    bool IsHeldBy(ThreadId threadId) const
+    {
+        return mRefCount != 0 && mThreadId == threadId;
+    }
+
+    bool IsFree() const
+    {
+        return mRefCount == 0;
+    }
+
+    void Acquire(ThreadId threadId)
+    {
+        if (mRefCount++ == 0)
+            mThreadId = threadId;
+    }
+
+    void Release()
+    {
+        CRUNCH_ASSERT_MSG(mRefCount != 0, "Releasing free task scheduler context");
+        mRefCount--;
+    }
+
+    void Push(Task* task)
+    {
+        mTasks.Push(task);
+    }
+
+    Task* Steal()
+    {
+        for (;;)
+        {
+            if (Task* task = mTasks.Steal())
+                return task;
+
+            // Steal fails spuriously when racing other thieves or the owner. Only give up when empty.
+            if (mTasks.IsEmpty())
+                return nullptr;
+
+            CRUNCH_PAUSE();
+        }
+    }
+
+    virtual State Run(IThrottler& throttler) CRUNCH_OVERRIDE
+    {
+        ScopedCurrentContext const scopedCurrent(this);
+
+        if (mIdle)
+        {
+            mIdle = false;
+            mOwner.mIdleContextCount.Decrement();
+        }
+
+        while (!throttler.ShouldYield())
+        {
+            Task* task = FindTask();
+            if (task == nullptr)
+            {
+                // Announce idle transition before checking for work one last time. Pairs with the fence in AddTask
+                // so that either AddTask sees this context idle and sets the has work condition, or we see the task.
+                mOwner.mIdleContextCount.Increment();
+                mOwner.mHasWork.Reset();
+
+                task = FindTask();
+                if (task == nullptr)
+                {
+                    mIdle = true;
+                    return State::Idle;
+                }
+
+                mOwner.mIdleContextCount.Decrement();
+            }
+
+            task->Run();
+            delete task;
+
+            // A cooperative wait inside the task may have run this context until idle
+            if (mIdle)
+            {
+                mIdle = false;
+                mOwner.mIdleContextCount.Decrement();
+            }
+        }
+
+        return State::Working;
+    }
+
+    /// Tasks only run from the owning thread, so a task waiting cooperatively can run further tasks
+    virtual bool CanReEnter() CRUNCH_OVERRIDE
+    {
+        return true;
+    }
+
+    virtual IWaitable& GetHasWorkCondition() CRUNCH_OVERRIDE
+    {
+        return mOwner.mHasWork;
+    }
+
+private:
+    class ScopedCurrentContext : NonCopyable
+    {
+    public:
+        ScopedCurrentContext(ContextImpl* context)
+            : mPrevious(tCurrentContext)
+        {
+            tCurrentContext = context;
+        }
+
+        ~ScopedCurrentContext()
+        {
+            tCurrentContext = mPrevious;
+        }
+
+    private:
+        ContextImpl* mPrevious;
+    };
+
+    Task* FindTask()
+    {
+        if (Task* task = mTasks.Pop())
+            return task;
+
+        if (Task* task = mOwner.PopInjected())
+            return task;
+
+        return StealFromOthers();
+    }
+
+    Task* StealFromOthers()
+    {
+        std::uint32_t const count = mOwner.mContextCount.Load(MEMORY_ORDER_ACQUIRE);
+        if (count < 2)
+            return nullptr;
+
+        // Start at a random victim to spread thieves across contexts
+        std::uint32_t const start = NextRandom() % count;
+        for (std::uint32_t i = 0; i < count; ++i)
+        {
+            ContextImpl* const victim = mOwner.mContexts[(start + i) % count].get();
+            if (victim == this)
+                continue;
+
+            if (Task* task = victim->Steal())
+                return task;
+        }
+
+        return nullptr;
+    }
+
+    std::uint32_t NextRandom()
+    {
+        // xorshift32
+        std::uint32_t x = mRandomState;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        mRandomState = x;
+        return x;
+    }
+
+    TaskScheduler& mOwner;
+    ThreadId mThreadId;
+    std::uint32_t mRefCount;
+    WorkStealingDeque<Task> mTasks;
+    std::uint32_t mRandomState;
+    bool mIdle;
+};
+
+CRUNCH_THREAD_LOCAL TaskScheduler::ContextImpl* TaskScheduler::tCurrentContext = nullptr;
+
+TaskScheduler::TaskScheduler(std::uint32_t maxContextCount)
+    : mMaxContextCount(maxContextCount)
+    , mContextCount(0, MEMORY_ORDER_RELAXED)
+    , mInjectedCount(0, MEMORY_ORDER_RELAXED)
+    , mIdleContextCount(0, MEMORY_ORDER_RELAXED)
+    , mHasWork(false)
+{
+    mContexts.reserve(maxContextCount);
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    // Run any remaining tasks. Tasks may post more tasks, so keep going until a full pass finds nothing.
+    bool ranAny;
+    do
+    {
+        ranAny = false;
+
+        while (Task* task = PopInjected())
+        {
+            task->Run();
+            delete task;
+            ranAny = true;
+        }
+
+        std::for_each(mContexts.begin(), mContexts.end(), [&] (ContextPtr const& context)
+        {
+            while (Task* task = context->Steal())
+            {
+                task->Run();
+                delete task;
+                ranAny = true;
+            }
+        });
+    } while (ranAny);
+}
+
+bool TaskScheduler::CanOrphan()
+{
+    // Tasks left on a context's deque can be stolen by any other context
+    return true;
+}
+
+ISchedulerContext& TaskScheduler::GetContext()
+{
+    ThreadId const threadId = GetThreadId();
+
+    Detail::SystemMutex::ScopedLock const lock(mContextsLock);
+
+    auto it = std::find_if(mContexts.begin(), mContexts.end(), [&] (ContextPtr const& context)
+    {
+        return context->IsHeldBy(threadId);
+    });
+
+    // Take over a context released by a thread that is done with it
+    if (it == mContexts.end())
+        it = std::find_if(mContexts.begin(), mContexts.end(), [] (ContextPtr const& context) { return context->IsFree(); });
+
+    if (it != mContexts.end())
+    {
+        (*it)->Acquire(threadId);
+        return **it;
+    }
+
+    CRUNCH_ASSERT_MSG_ALWAYS(mContexts.size() < mMaxContextCount, "Exceeded max context count (%d)", mMaxContextCount);
+
+    std::uint32_t const index = static_cast<std::uint32_t>(mContexts.size());
+    mContexts.push_back(ContextPtr(new ContextImpl(*this, threadId, index + 1)));
+    mContextCount.Store(index + 1, MEMORY_ORDER_RELEASE);
+    return *mContexts.back();
+}
+
+void TaskScheduler::ReleaseContext(ISchedulerContext& context)
+{
+    ContextImpl& impl = static_cast<ContextImpl&>(context);
+    CRUNCH_ASSERT_MSG(&impl.GetOwner() == this, "Context belongs to different TaskScheduler instance");
+
+    Detail::SystemMutex::ScopedLock const lock(mContextsLock);
+    impl.Release();
+}
+
+void TaskScheduler::AddTask(Task* task)
+{
+    ContextImpl* const context = tCurrentContext;
+    if (context != nullptr && &context->GetOwner() == this)
+    {
+        context->Push(task);
+    }
+    else
+    {
+        Detail::SystemMutex::ScopedLock const lock(mInjectedLock);
+        mInjected.push_back(task);
+        mInjectedCount.Increment();
+    }
+
+    // Pairs with idle announcement in ContextImpl::Run
+    CRUNCH_MEMORY_FENCE();
+
+    if (mIdleContextCount.Load(MEMORY_ORDER_RELAXED) != 0)
+        mHasWork.Set();
+}
+
+TaskScheduler::Task* TaskScheduler::PopInjected()
+{
+    if (mInjectedCount.Load(MEMORY_ORDER_RELAXED) == 0)
+        return nullptr;
+
+    Detail::SystemMutex::ScopedLock const lock(mInjectedLock);
+    if (mInjected.empty())
+        return nullptr;
+
+    Task* const task = mInjected.front();
+    mInjected.pop_front();
+    mInjectedCount.Decrement();
+    return task;
+}
+
+}}
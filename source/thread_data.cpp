@@ -3,6 +3,10 @@
 
 #include "./thread_data.hpp"
 
+#include "crunch/concurrency/epoch.hpp"
+#include "crunch/concurrency/queue_mutex.hpp"
+#include "crunch/concurrency/thread_pool.hpp"
+
 namespace Crunch { namespace Concurrency {
 
 CRUNCH_THREAD_LOCAL Thread::Data* Thread::Data::tCurrent = NULL;
@@ -27,6 +31,10 @@ void* Thread::Data::EntryPoint(void* argument)
         std::terminate();
     }
 
+    Detail::ReleaseEpochRecord();
+    Detail::ReleaseWorkItemSlotCache();
+    Detail::ReleaseQueueMutexNodeCache();
+
     return 0;
 }
 
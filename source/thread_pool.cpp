@@ -3,16 +3,251 @@
 
 #include "crunch/concurrency/thread_pool.hpp"
 
+#include "crunch/base/assert.hpp"
+#include "crunch/concurrency/fence.hpp"
+#include "crunch/concurrency/mpmc_lifo_list.hpp"
+#include "crunch/concurrency/work_stealing_deque.hpp"
+#include "crunch/concurrency/yield.hpp"
+#include "crunch/concurrency/detail/system_semaphore.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
 namespace Crunch { namespace Concurrency {
 
-ThreadPool::ThreadPool(std::uint32_t maxThreadCount)
+namespace
+{
+    struct WorkItemSlot
+    {
+        WorkItemSlot* next;
+    };
+
+    void SetNext(WorkItemSlot& slot, WorkItemSlot* next)
+    {
+        slot.next = next;
+    }
+
+    WorkItemSlot* GetNext(WorkItemSlot const& slot)
+    {
+        return slot.next;
+    }
+
+    /// Allocates work item slots in chunks. Slots are recycled through a lock-free free list and never returned to
+    /// the system, so the memory is type stable for MPMCLifoList.
+    class WorkItemSlotAllocator
+    {
+    public:
+        ~WorkItemSlotAllocator()
+        {
+            std::for_each(mChunks.begin(), mChunks.end(), [] (void* chunk) { std::free(chunk); });
+        }
+
+        void* Allocate(std::size_t slotSize)
+        {
+            if (WorkItemSlot* slot = mFreeList.Pop())
+                return slot;
+
+            Detail::SystemMutex::ScopedLock const lock(mChunksLock);
+            char* const chunk = static_cast<char*>(std::malloc(slotSize * SLOTS_PER_CHUNK));
+            mChunks.push_back(chunk);
+
+            for (std::size_t i = 1; i < SLOTS_PER_CHUNK; ++i)
+                mFreeList.Push(reinterpret_cast<WorkItemSlot*>(chunk + i * slotSize));
+
+            return chunk;
+        }
+
+        void Free(void* allocation)
+        {
+            mFreeList.Push(static_cast<WorkItemSlot*>(allocation));
+        }
+
+    private:
+        static std::size_t const SLOTS_PER_CHUNK = 256;
+
+        MPMCLifoList<WorkItemSlot> mFreeList;
+        Detail::SystemMutex mChunksLock;
+        std::vector<void*> mChunks;
+    };
+
+    WorkItemSlotAllocator gWorkItemSlotAllocator;
+
+    // Slots are usually freed on a different thread than they're allocated on, so bound the local cache and
+    // overflow to the global free list. The cache is handed back on thread exit.
+    std::uint32_t const LOCAL_SLOT_CACHE_LIMIT = 256;
+    CRUNCH_THREAD_LOCAL WorkItemSlot* tFreeSlots = nullptr;
+    CRUNCH_THREAD_LOCAL std::uint32_t tFreeSlotCount = 0;
+}
+
+void* ThreadPool::AllocateSlot()
+{
+    WorkItemSlot* const localFree = tFreeSlots;
+    if (localFree)
+    {
+        tFreeSlots = localFree->next;
+        tFreeSlotCount--;
+        return localFree;
+    }
+
+    return gWorkItemSlotAllocator.Allocate(WORK_ITEM_SLOT_SIZE);
+}
+
+void ThreadPool::FreeSlot(void* slot)
+{
+    WorkItemSlot* const node = static_cast<WorkItemSlot*>(slot);
+    if (tFreeSlotCount < LOCAL_SLOT_CACHE_LIMIT)
+    {
+        node->next = tFreeSlots;
+        tFreeSlots = node;
+        tFreeSlotCount++;
+    }
+    else
+    {
+        gWorkItemSlotAllocator.Free(node);
+    }
+}
+
+void Detail::ReleaseWorkItemSlotCache()
+{
+    while (WorkItemSlot* const slot = tFreeSlots)
+    {
+        tFreeSlots = slot->next;
+        gWorkItemSlotAllocator.Free(slot);
+    }
+
+    tFreeSlotCount = 0;
+}
+
+struct ThreadPool::Worker : NonCopyable
+{
+    Worker(ThreadPool& owner, std::uint32_t index)
+        : owner(owner)
+        , index(index)
+        , inbox(nullptr, MEMORY_ORDER_RELAXED)
+        , sleeping(0, MEMORY_ORDER_RELAXED)
+        , wakeup(0)
+    {}
+
+    /// Move all work posted to inbox onto deque, oldest first
+    /// \param source Inbox to drain. Either the worker's own, or a victim's.
+    bool DrainInbox(Atomic<WorkItem*>& source)
+    {
+        if (source.Load(MEMORY_ORDER_RELAXED) == nullptr)
+            return false;
+
+        // Taking the whole list with a swap is immune to ABA, so no tagging needed
+        WorkItem* node = source.Swap(nullptr);
+        if (node == nullptr)
+            return false;
+
+        WorkItem* reversed = nullptr;
+        while (node)
+        {
+            WorkItem* const next = node->next;
+            node->next = reversed;
+            reversed = node;
+            node = next;
+        }
+
+        while (reversed)
+        {
+            WorkItem* const next = reversed->next;
+            queue.Push(reversed);
+            reversed = next;
+        }
+
+        return true;
+    }
+
+    ThreadPool& owner;
+    std::uint32_t const index;
+
+    // Owner pushes to bottom, and both owner and thieves take from top to preserve FIFO order
+    WorkStealingDeque<WorkItem> queue;
+
+    // Lock-free LIFO of work posted from other threads
+    Atomic<WorkItem*> inbox;
+
+    Atomic<std::uint32_t> sleeping;
+    Detail::SystemSemaphore wakeup;
+    Thread thread;
+};
+
+namespace
+{
+    // Number of times an idle worker polls for work before parking
+    std::uint32_t const IDLE_SPIN_COUNT = 2000;
+}
+
+CRUNCH_THREAD_LOCAL ThreadPool::Worker* ThreadPool::tCurrentWorker = nullptr;
+
+ThreadPool::ThreadPool(std::uint32_t maxThreadCount, Mode mode)
     : mMaxThreadCount(maxThreadCount)
+    , mMode(mode)
     , mStop(false)
     , mIdleThreadCount(0)
-{}
+    , mWorkHead(nullptr)
+    , mWorkTail(nullptr)
+    , mNextWorker(0, MEMORY_ORDER_RELAXED)
+    , mSleepingCount(0, MEMORY_ORDER_RELAXED)
+{
+    if (mMode == MODE_HIGH_THROUGHPUT)
+    {
+        // Post distributes work round robin over the workers
+        CRUNCH_ASSERT_MSG_ALWAYS(mMaxThreadCount > 0, "High throughput thread pool needs at least one thread");
+
+        // Create all workers before starting threads so the worker list is stable for stealing
+        for (std::uint32_t i = 0; i < mMaxThreadCount; ++i)
+            mWorkers.push_back(WorkerPtr(new Worker(*this, i)));
+
+        std::for_each(mWorkers.begin(), mWorkers.end(), [&] (WorkerPtr const& worker)
+        {
+            Worker* const w = worker.get();
+            w->thread = Thread([=] { RunWorker(*w); });
+        });
+    }
+}
 
 ThreadPool::~ThreadPool()
 {
+    if (mMode == MODE_HIGH_THROUGHPUT)
+    {
+        mStop = true;
+
+        // Pairs with fence in Park
+        CRUNCH_MEMORY_FENCE();
+
+        std::for_each(mWorkers.begin(), mWorkers.end(), [&] (WorkerPtr const& worker)
+        {
+            Wake(*worker);
+        });
+
+        std::for_each(mWorkers.begin(), mWorkers.end(), [] (WorkerPtr const& worker)
+        {
+            worker->thread.Join();
+        });
+
+        // Run remaining work on the destroying thread. Work may post more work to workers already drained, so
+        // repeat until a full pass finds nothing.
+        bool ranWork;
+        do
+        {
+            ranWork = false;
+            std::for_each(mWorkers.begin(), mWorkers.end(), [&] (WorkerPtr const& worker)
+            {
+                worker->DrainInbox(worker->inbox);
+                while (WorkItem* item = worker->queue.Steal())
+                {
+                    item->run(item);
+                    ranWork = true;
+                }
+            });
+        }
+        while (ranWork);
+
+        return;
+    }
+
     {
         Detail::SystemMutex::ScopedLock const lock(mLock);
         mStop = true;
@@ -24,23 +259,40 @@ ThreadPool::~ThreadPool()
         t.Join();
     });
 
-    std::for_each(mWork.begin(), mWork.end(), [] (WorkItem const& workItem)
+    while (WorkItem* item = mWorkHead)
     {
-        workItem();
-    });
+        mWorkHead = item->next;
+        item->run(item);
+    }
 }
 
 std::uint32_t ThreadPool::GetThreadCount() const
 {
+    if (mMode == MODE_HIGH_THROUGHPUT)
+        return static_cast<std::uint32_t>(mWorkers.size());
+
     Detail::SystemMutex::ScopedLock lock(mLock);
     return static_cast<std::uint32_t>(mThreads.size());
 }
 
-void ThreadPool::AddWorkItem(WorkItem&& work)
+void ThreadPool::AddWorkItem(WorkItem* work)
+{
+    if (mMode == MODE_HIGH_THROUGHPUT)
+        AddWorkItemHighThroughput(work);
+    else
+        AddWorkItemSimple(work);
+}
+
+void ThreadPool::AddWorkItemSimple(WorkItem* work)
 {
     Detail::SystemMutex::ScopedLock lock(mLock);
 
-    mWork.push_back(std::move(work));
+    work->next = nullptr;
+    if (mWorkTail)
+        mWorkTail->next = work;
+    else
+        mWorkHead = work;
+    mWorkTail = work;
 
     if (mIdleThreadCount == 0 &&
         mThreads.size() < mMaxThreadCount)
@@ -52,7 +304,7 @@ void ThreadPool::AddWorkItem(WorkItem&& work)
                 mLock.Lock();
                 mIdleThreadCount++;
 
-                while (mWork.empty())
+                while (mWorkHead == nullptr)
                 {
                     mHasWork.Wait(mLock);
                     if (mStop)
@@ -63,19 +315,15 @@ void ThreadPool::AddWorkItem(WorkItem&& work)
                     }
                 }
 
-                WorkItem workItem = std::move(mWork.front());
-                mWork.pop_front();
+                WorkItem* const workItem = mWorkHead;
+                mWorkHead = workItem->next;
+                if (mWorkHead == nullptr)
+                    mWorkTail = nullptr;
 
                 mIdleThreadCount--;
                 mLock.Unlock();
 
-                try
-                {
-                    workItem();
-                }
-                catch (...)
-                {
-                }
+                workItem->run(workItem);
             }
         }));
     }
@@ -85,5 +333,135 @@ void ThreadPool::AddWorkItem(WorkItem&& work)
     }
 }
 
+void ThreadPool::AddWorkItemHighThroughput(WorkItem* work)
+{
+    Worker* const current = tCurrentWorker;
+    if (current != nullptr && &current->owner == this)
+    {
+        // Posted from one of our own workers. Keep it local, others will steal if idle.
+        current->queue.Push(work);
+
+        // Pairs with fence in Park
+        CRUNCH_MEMORY_FENCE();
+
+        if (mSleepingCount.Load(MEMORY_ORDER_RELAXED) != 0)
+            WakeOne();
+    }
+    else
+    {
+        Worker& target = *mWorkers[mNextWorker.Increment(MEMORY_ORDER_RELAXED) % mWorkers.size()];
+
+        WorkItem* head = target.inbox.Load(MEMORY_ORDER_RELAXED);
+        for (;;)
+        {
+            work->next = head;
+            if (target.inbox.CompareAndSwap(head, work))
+                break;
+        }
+
+        CRUNCH_MEMORY_FENCE();
+
+        // Prefer to wake the target, but if it's busy another sleeping worker can steal its inbox
+        if (!Wake(target) && mSleepingCount.Load(MEMORY_ORDER_RELAXED) != 0)
+            WakeOne();
+    }
+}
+
+void ThreadPool::RunWorker(Worker& worker)
+{
+    tCurrentWorker = &worker;
+
+    std::uint32_t idleSpins = 0;
+    while (!mStop)
+    {
+        if (WorkItem* item = FindWork(worker))
+        {
+            item->run(item);
+            idleSpins = 0;
+        }
+        else if (idleSpins++ < IDLE_SPIN_COUNT)
+        {
+            CRUNCH_PAUSE();
+        }
+        else
+        {
+            Park(worker);
+            idleSpins = 0;
+        }
+    }
+}
+
+ThreadPool::WorkItem* ThreadPool::FindWork(Worker& worker)
+{
+    worker.DrainInbox(worker.inbox);
+
+    if (WorkItem* item = worker.queue.Steal())
+        return item;
+
+    std::uint32_t const count = static_cast<std::uint32_t>(mWorkers.size());
+    for (std::uint32_t i = 1; i < count; ++i)
+    {
+        Worker& victim = *mWorkers[(worker.index + i) % count];
+
+        if (WorkItem* item = victim.queue.Steal())
+            return item;
+
+        // Take over the inbox of a worker that's busy
+        if (worker.DrainInbox(victim.inbox))
+        {
+            if (WorkItem* item = worker.queue.Steal())
+                return item;
+        }
+    }
+
+    return nullptr;
+}
+
+bool ThreadPool::HasWork() const
+{
+    return std::any_of(mWorkers.begin(), mWorkers.end(), [] (WorkerPtr const& worker)
+    {
+        return worker->inbox.Load(MEMORY_ORDER_RELAXED) != nullptr || !worker->queue.IsEmpty();
+    });
+}
+
+void ThreadPool::Park(Worker& worker)
+{
+    // Announce intent to sleep before checking for work one last time. Producers publish work before checking
+    // for sleepers, so either they see us sleeping and wake us, or we see their work.
+    worker.sleeping.Store(1);
+    mSleepingCount.Increment();
+
+    if (!mStop && !HasWork())
+    {
+        worker.wakeup.Wait();
+    }
+    else if (worker.sleeping.Swap(0) == 0)
+    {
+        // Lost race with a waker. Consume its post to keep the semaphore balanced.
+        worker.wakeup.Wait();
+    }
+
+    mSleepingCount.Decrement();
+}
+
+bool ThreadPool::Wake(Worker& worker)
+{
+    if (worker.sleeping.Load(MEMORY_ORDER_RELAXED) != 0 && worker.sleeping.Swap(0) != 0)
+    {
+        worker.wakeup.Post();
+        return true;
+    }
+
+    return false;
+}
+
+void ThreadPool::WakeOne()
+{
+    std::find_if(mWorkers.begin(), mWorkers.end(), [&] (WorkerPtr const& worker)
+    {
+        return Wake(*worker);
+    });
+}
 
-}}
\ No newline at end of file
+}}
@@ -0,0 +1,137 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#include "crunch/concurrency/tree_barrier.hpp"
+#include "crunch/concurrency/yield.hpp"
+
+#include "crunch/base/assert.hpp"
+
+#include <algorithm>
+#include <map>
+#include <new>
+#include <utility>
+
+namespace Crunch { namespace Concurrency {
+
+TreeBarrier::TreeBarrier(ProcessorTopology const& topology, std::uint32_t participantCount, std::uint32_t spinCount)
+    : mSpinCount(spinCount)
+{
+    CRUNCH_ASSERT_MSG(participantCount != 0, "Barrier must have participants");
+
+    ProcessorTopology::ProcessorList processors = topology.GetProcessors();
+    CRUNCH_ASSERT_ALWAYS(!processors.empty());
+
+    std::sort(processors.begin(), processors.end(), [] (ProcessorTopology::Processor const& a, ProcessorTopology::Processor const& b)
+    {
+        if (a.packageId != b.packageId)
+            return a.packageId < b.packageId;
+        if (a.coreId != b.coreId)
+            return a.coreId < b.coreId;
+        return a.threadId < b.threadId;
+    });
+
+    for (std::uint32_t i = 0; i < participantCount; ++i)
+        mProcessors.push_back(processors[i % processors.size()]);
+
+    // Group participants by core, and cores by package
+    typedef std::pair<std::uint32_t, std::uint32_t> CoreKey;
+    std::map<CoreKey, std::vector<std::uint32_t>> participantsByCore;
+    std::map<std::uint32_t, std::vector<CoreKey>> coresByPackage;
+    for (std::uint32_t i = 0; i < participantCount; ++i)
+    {
+        CoreKey const core(mProcessors[i].packageId, mProcessors[i].coreId);
+        std::vector<std::uint32_t>& participants = participantsByCore[core];
+        if (participants.empty())
+            coresByPackage[core.first].push_back(core);
+        participants.push_back(i);
+    }
+
+    // Build top down. Levels with a single arrival are skipped, as a counter of one would only add latency.
+    Node* const root = coresByPackage.size() > 1 ? AddNode(static_cast<std::uint32_t>(coresByPackage.size())) : nullptr;
+
+    mLeaves.resize(participantCount, nullptr);
+    std::for_each(coresByPackage.begin(), coresByPackage.end(), [&] (std::pair<std::uint32_t const, std::vector<CoreKey>> const& package)
+    {
+        Node* const packageNode = package.second.size() > 1 ? AddNode(static_cast<std::uint32_t>(package.second.size())) : nullptr;
+        if (packageNode)
+            packageNode->parent = root;
+
+        std::for_each(package.second.begin(), package.second.end(), [&] (CoreKey const& core)
+        {
+            std::vector<std::uint32_t> const& participants = participantsByCore[core];
+            Node* const coreParent = packageNode ? packageNode : root;
+            Node* coreNode = coreParent;
+            if (participants.size() > 1)
+            {
+                coreNode = AddNode(static_cast<std::uint32_t>(participants.size()));
+                coreNode->parent = coreParent;
+            }
+
+            std::for_each(participants.begin(), participants.end(), [&] (std::uint32_t participant)
+            {
+                mLeaves[participant] = coreNode;
+            });
+        });
+    });
+
+    mPhase.value.Store(0, MEMORY_ORDER_RELEASE);
+}
+
+TreeBarrier::~TreeBarrier()
+{
+    std::for_each(mNodes.begin(), mNodes.end(), [] (AlignedNode* node)
+    {
+        node->~AlignedNode();
+        Detail::FreeCacheLineAligned(node);
+    });
+}
+
+TreeBarrier::Node* TreeBarrier::AddNode(std::uint32_t count)
+{
+    AlignedNode* const node = new (Detail::AllocateCacheLineAligned(sizeof(AlignedNode))) AlignedNode();
+    node->value.remaining.Store(count, MEMORY_ORDER_RELAXED);
+    node->value.count = count;
+    node->value.parent = nullptr;
+    mNodes.push_back(node);
+    return &node->value;
+}
+
+bool TreeBarrier::Wait(std::uint32_t participant)
+{
+    CRUNCH_ASSERT(participant < mLeaves.size());
+
+    // Phase can't complete before this participant has arrived
+    std::uint32_t const phase = mPhase.value.Load(MEMORY_ORDER_ACQUIRE);
+
+    // Climb while last to arrive. Counters are reset on the way up, as the subtree below can't arrive again until
+    // the phase completes.
+    Node* node = mLeaves[participant];
+    while (node != nullptr)
+    {
+        if (node->remaining.Decrement(MEMORY_ORDER_ACQ_REL) != 1)
+            break;
+
+        node->remaining.Store(node->count, MEMORY_ORDER_RELAXED);
+        node = node->parent;
+    }
+
+    if (node == nullptr)
+    {
+        mPhase.value.Store(phase + 1, MEMORY_ORDER_RELEASE);
+        mPhase.value.NotifyAll();
+        return true;
+    }
+
+    for (std::uint32_t i = 0; i < mSpinCount; ++i)
+    {
+        if (mPhase.value.Load(MEMORY_ORDER_ACQUIRE) != phase)
+            return false;
+
+        CRUNCH_PAUSE();
+    }
+
+    mPhase.value.Wait(phase, MEMORY_ORDER_ACQUIRE);
+    return false;
+}
+
+}}
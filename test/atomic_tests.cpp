@@ -2,6 +2,8 @@
 // Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
 
 #include "crunch/concurrency/atomic.hpp"
+#include "crunch/concurrency/tagged_pointer.hpp"
+#include "crunch/concurrency/thread.hpp"
 #include "crunch/test/framework.hpp"
 
 #include <boost/mpl/list.hpp>
@@ -152,6 +154,70 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(XorTest, T, AtomicXorTypes)
     BOOST_CHECK_EQUAL(value, T(0x60));
 }
 
+BOOST_AUTO_TEST_CASE(TaggedPointerCompareAndSwapTest)
+{
+    int a = 0;
+    int b = 0;
+    TaggedPointer<int> const initial = { &a, 1 };
+    TaggedPointer<int> const replacement = { &b, 2 };
+    Atomic<TaggedPointer<int>> value(initial);
+
+    // Same pointer with different tag must fail and return current value
+    TaggedPointer<int> cmp = { &a, 0 };
+    BOOST_CHECK(!value.CompareAndSwap(cmp, replacement));
+    BOOST_CHECK(cmp == initial);
+
+    BOOST_CHECK(value.CompareAndSwap(cmp, replacement));
+    BOOST_CHECK(value.Load() == replacement);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(WaitNotifyTest, T, AtomicTypes)
+{
+    Atomic<T> value(0);
+
+    // Returns immediately when value already differs
+    value.Wait(T(1));
+
+    // Each round the other thread waits for the value to move on, then moves it on itself
+    Thread thread([&]
+    {
+        for (T i = 0; i < 100; i += 2)
+        {
+            value.Wait(i);
+            value.Store(i + 2);
+            value.NotifyOne();
+        }
+    });
+
+    for (T i = 1; i < 100; i += 2)
+    {
+        value.Store(i);
+        value.NotifyAll();
+        value.Wait(i);
+    }
+
+    thread.Join();
+    BOOST_CHECK_EQUAL(value.Load(), T(100));
+}
+
+BOOST_AUTO_TEST_CASE(TaggedPointerWaitNotifyTest)
+{
+    int a = 0;
+    TaggedPointer<int> const initial = { &a, 1 };
+    TaggedPointer<int> const changed = { &a, 2 };
+    Atomic<TaggedPointer<int>> value(initial);
+
+    Thread thread([&]
+    {
+        value.Store(changed);
+        value.NotifyAll();
+    });
+
+    value.Wait(initial);
+    BOOST_CHECK(value.Load() == changed);
+    thread.Join();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }}
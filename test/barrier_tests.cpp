@@ -0,0 +1,125 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#include "crunch/concurrency/barrier.hpp"
+#include "crunch/concurrency/thread.hpp"
+#include "crunch/concurrency/tree_barrier.hpp"
+#include "crunch/test/framework.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace Crunch { namespace Concurrency {
+
+BOOST_AUTO_TEST_SUITE(BarrierTests)
+
+namespace
+{
+    /// Every participant checks that no one is a phase ahead, and at most one per phase completes it.
+    /// Exactly one if wait reports completion for every participant.
+    template<typename WaitFunction>
+    void RunPhasesTest(std::uint32_t participantCount, WaitFunction wait, bool reportsAllCompletions = true)
+    {
+        std::uint32_t const phaseCount = 200;
+        Atomic<std::uint32_t> arrivals(0);
+        Atomic<std::uint32_t> completions(0);
+
+        std::vector<Thread> threads;
+        for (std::uint32_t p = 0; p < participantCount; ++p)
+        {
+            threads.push_back(Thread([&, p]
+            {
+                for (std::uint32_t phase = 0; phase < phaseCount; ++phase)
+                {
+                    arrivals.Increment();
+                    if (wait(p))
+                        completions.Increment();
+
+                    // Everyone has arrived for this phase, and no one can have arrived for the one after next
+                    std::uint32_t const seen = arrivals.Load();
+                    BOOST_REQUIRE_GE(seen, (phase + 1) * participantCount);
+                    BOOST_REQUIRE_LE(seen, (phase + 2) * participantCount);
+                }
+            }));
+        }
+
+        std::for_each(threads.begin(), threads.end(), [] (Thread& t) { t.Join(); });
+        if (reportsAllCompletions)
+            BOOST_CHECK_EQUAL(completions.Load(), phaseCount);
+        else
+            BOOST_CHECK_LE(completions.Load(), phaseCount);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(SingleParticipantTest)
+{
+    Barrier barrier(1);
+    BOOST_CHECK(barrier.Wait());
+    BOOST_CHECK(barrier.Wait());
+
+    volatile bool called = false;
+    BOOST_CHECK(!barrier.AddWaiter([&] { called = true; }));
+    BOOST_CHECK(!called);
+}
+
+BOOST_AUTO_TEST_CASE(PhasesTest)
+{
+    Barrier barrier(4, 10);
+    RunPhasesTest(4, [&] (std::uint32_t) { return barrier.Wait(); });
+}
+
+BOOST_AUTO_TEST_CASE(WaitForTest)
+{
+    Barrier barrier(3);
+    RunPhasesTest(3, [&] (std::uint32_t p) -> bool
+    {
+        if (p == 0)
+            return barrier.Wait();
+
+        // WaitFor doesn't tell whether this arrival completed the phase
+        WaitFor(barrier, WaitMode::Block());
+        return false;
+    }, false);
+}
+
+BOOST_AUTO_TEST_CASE(AddRemoveWaiterTest)
+{
+    Barrier barrier(2);
+    volatile std::uint32_t wakeupCount = 0;
+
+    auto waiter = Waiter::Create([&] { wakeupCount++; }, false);
+
+    // Withdrawn arrival doesn't count towards the phase
+    BOOST_CHECK(barrier.AddWaiter(waiter));
+    BOOST_CHECK(barrier.RemoveWaiter(waiter));
+    BOOST_CHECK(!barrier.RemoveWaiter(waiter));
+
+    // Last arrival completes the phase and notifies the others, but not itself
+    BOOST_CHECK(barrier.AddWaiter(waiter));
+    BOOST_CHECK(!barrier.AddWaiter([&] { wakeupCount += 10; }));
+    BOOST_CHECK_EQUAL(wakeupCount, 1u);
+    BOOST_CHECK(!barrier.RemoveWaiter(waiter));
+
+    waiter->Destroy();
+}
+
+BOOST_AUTO_TEST_CASE(TreeBarrierPhasesTest)
+{
+    ProcessorTopology const topology;
+    std::uint32_t const participantCount = std::max<std::uint32_t>(4, GetSystemNumProcessors());
+
+    TreeBarrier barrier(topology, participantCount, 10);
+    RunPhasesTest(participantCount, [&] (std::uint32_t p) { return barrier.Wait(p); });
+}
+
+BOOST_AUTO_TEST_CASE(TreeBarrierSingleParticipantTest)
+{
+    ProcessorTopology const topology;
+    TreeBarrier barrier(topology, 1);
+    BOOST_CHECK(barrier.Wait(0));
+    BOOST_CHECK(barrier.Wait(0));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}}
@@ -0,0 +1,72 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#include "crunch/concurrency/epoch.hpp"
+#include "crunch/concurrency/thread.hpp"
+#include "crunch/concurrency/yield.hpp"
+#include "crunch/test/framework.hpp"
+
+#include "./tracked_object.hpp"
+
+namespace Crunch { namespace Concurrency {
+
+BOOST_AUTO_TEST_SUITE(EpochTests)
+
+BOOST_AUTO_TEST_CASE(RetireOutsideCriticalRegionTest)
+{
+    Atomic<std::uint32_t> reclaimed(0);
+    for (int i = 0; i < 10; ++i)
+        Epoch::Retire(new TrackedObject(reclaimed));
+
+    QuiesceUntil<Epoch>(reclaimed, 10);
+    BOOST_CHECK_EQUAL(reclaimed.Load(), 10u);
+}
+
+BOOST_AUTO_TEST_CASE(CriticalRegionBlocksReclaimTest)
+{
+    Atomic<std::uint32_t> reclaimed(0);
+    Atomic<std::uint32_t> stage(0);
+
+    // Other thread enters a critical region before the object is retired
+    Thread reader([&]
+    {
+        Epoch::Guard const guard;
+        stage.Store(1);
+        while (stage.Load() != 2)
+            ThreadYield();
+    });
+
+    while (stage.Load() != 1)
+        ThreadYield();
+
+    Epoch::Retire(new TrackedObject(reclaimed));
+    for (int i = 0; i < 100; ++i)
+        Epoch::Quiesce();
+
+    BOOST_CHECK_EQUAL(reclaimed.Load(), 0u);
+
+    stage.Store(2);
+    reader.Join();
+
+    QuiesceUntil<Epoch>(reclaimed, 1);
+    BOOST_CHECK_EQUAL(reclaimed.Load(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(NestedGuardTest)
+{
+    Atomic<std::uint32_t> reclaimed(0);
+    {
+        Epoch::Guard const outer;
+        {
+            Epoch::Guard const inner;
+        }
+        Epoch::Retire(new TrackedObject(reclaimed));
+    }
+
+    QuiesceUntil<Epoch>(reclaimed, 1);
+    BOOST_CHECK_EQUAL(reclaimed.Load(), 1u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}}
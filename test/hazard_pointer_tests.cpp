@@ -0,0 +1,54 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#include "crunch/concurrency/hazard_pointer.hpp"
+#include "crunch/test/framework.hpp"
+
+#include "./tracked_object.hpp"
+
+namespace Crunch { namespace Concurrency {
+
+BOOST_AUTO_TEST_SUITE(HazardPointerTests)
+
+BOOST_AUTO_TEST_CASE(ProtectTest)
+{
+    int value = 0;
+    Atomic<int*> source(&value);
+    HazardPointer hazard;
+    BOOST_CHECK_EQUAL(hazard.Protect(source), &value);
+}
+
+BOOST_AUTO_TEST_CASE(RetireUnprotectedTest)
+{
+    Atomic<std::uint32_t> reclaimed(0);
+    for (int i = 0; i < 1000; ++i)
+        HazardPointer::Retire(new TrackedObject(reclaimed));
+
+    HazardPointer::ReclaimAll();
+    BOOST_CHECK_EQUAL(reclaimed.Load(), 1000u);
+}
+
+BOOST_AUTO_TEST_CASE(RetireProtectedTest)
+{
+    Atomic<std::uint32_t> reclaimed(0);
+    TrackedObject* const protectedObject = new TrackedObject(reclaimed);
+
+    {
+        HazardPointer hazard;
+        hazard.Set(protectedObject);
+
+        HazardPointer::Retire(protectedObject);
+        for (int i = 0; i < 1000; ++i)
+            HazardPointer::Retire(new TrackedObject(reclaimed));
+
+        HazardPointer::ReclaimAll();
+        BOOST_CHECK_EQUAL(reclaimed.Load(), 1000u);
+    }
+
+    HazardPointer::ReclaimAll();
+    BOOST_CHECK_EQUAL(reclaimed.Load(), 1001u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}}
@@ -4,11 +4,15 @@
 #include "crunch/base/override.hpp"
 #include "crunch/concurrency/event.hpp"
 #include "crunch/concurrency/meta_scheduler.hpp"
+#include "crunch/concurrency/mutex.hpp"
 #include "crunch/concurrency/thread.hpp"
 #include "crunch/concurrency/yield.hpp"
 #include "crunch/test/framework.hpp"
 
+#include <algorithm>
+#include <memory>
 #include <stdexcept>
+#include <vector>
 
 namespace Crunch { namespace Concurrency {
 
@@ -37,6 +41,103 @@ BOOST_AUTO_TEST_CASE(WaitTest)
     context.Release();
 }
 
+namespace
+{
+    void RunTimeoutTest()
+    {
+        WaitMode const timed = WaitMode::Block().WithTimeout(Duration::Milliseconds(10));
+
+        Event unset;
+        Event set;
+        set.Set();
+        Mutex locked;
+        locked.Lock();
+
+        BOOST_CHECK(!WaitFor(unset, timed));
+        BOOST_CHECK(WaitFor(set, timed));
+
+        // Timed WaitForAll doesn't take order dependent waitables
+        IWaitable* unsetWaitables[] = { &unset, &locked };
+        BOOST_CHECK(!WaitForAll(unsetWaitables, 1, timed));
+        BOOST_CHECK(WaitForAny(unsetWaitables, 2, timed).empty());
+
+        IWaitable* mixedWaitables[] = { &unset, &set };
+        BOOST_CHECK(!WaitForAll(mixedWaitables, 2, timed));
+        WaitForAnyResult const signaled = WaitForAny(mixedWaitables, 2, timed);
+        BOOST_CHECK_EQUAL(signaled.size(), 1u);
+        BOOST_CHECK(signaled.front() == &set);
+
+        // Waiters were removed on timeout, so the mutex isn't handed to them
+        BOOST_CHECK(!WaitFor(locked, timed));
+        locked.Unlock();
+        BOOST_CHECK(!locked.IsLocked());
+        unset.Set();
+
+        // Signaled from another thread before the timeout
+        Event later;
+        Thread setter([&]
+        {
+            ThreadSleep(Duration::Milliseconds(20));
+            later.Set();
+        });
+
+        IWaitable* laterWaitables[] = { &set, &later };
+        BOOST_CHECK(WaitForAll(laterWaitables, 2, WaitMode::Block().WithTimeout(Duration::Seconds(10))));
+        setter.Join();
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TimeoutTest)
+{
+    RunTimeoutTest();
+
+    MetaScheduler::Config configuration;
+    MetaScheduler ms(configuration);
+    MetaScheduler::Context& context = ms.AcquireContext();
+    RunTimeoutTest();
+    context.Release();
+}
+
+BOOST_AUTO_TEST_CASE(WaitForAnyFanInTest)
+{
+    // Enough waitables that the waiters don't fit on the stack
+    std::size_t const count = 1000;
+    std::vector<std::unique_ptr<Event>> events;
+    std::vector<IWaitable*> waitables;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        events.push_back(std::unique_ptr<Event>(new Event()));
+        waitables.push_back(events.back().get());
+    }
+
+    // Synchronously ready
+    events[count / 2]->Set();
+    WaitForAnyResult signaled = WaitForAny(&waitables[0], count, WaitMode::Block());
+    BOOST_CHECK_EQUAL(signaled.size(), 1u);
+    BOOST_CHECK(signaled.front() == events[count / 2].get());
+    events[count / 2]->Reset();
+
+    // Several set concurrently while waiting. All are reported, as their waiters can't be removed.
+    Thread setter([&]
+    {
+        ThreadSleep(Duration::Milliseconds(20));
+        for (std::size_t i = 0; i < count; i += 100)
+            events[i]->Set();
+    });
+
+    signaled = WaitForAny(&waitables[0], count, WaitMode::Block());
+    setter.Join();
+    BOOST_CHECK_GE(signaled.size(), 1u);
+    BOOST_CHECK_LE(signaled.size(), count / 100);
+    std::for_each(signaled.begin(), signaled.end(), [&] (IWaitable* waitable)
+    {
+        BOOST_CHECK(static_cast<Event*>(waitable)->IsSet());
+    });
+
+    // Waiters on unset events were removed, so setting them now notifies nobody
+    std::for_each(events.begin(), events.end(), [] (std::unique_ptr<Event> const& event) { event->Set(); });
+}
+
 BOOST_AUTO_TEST_CASE(RunTest)
 {
     struct TestScheduler : IScheduler
@@ -71,6 +172,10 @@ BOOST_AUTO_TEST_CASE(RunTest)
             return mContext;
         }
 
+        virtual void ReleaseContext(ISchedulerContext&) CRUNCH_OVERRIDE
+        {
+        }
+
         Context mContext;
     };
 
@@ -0,0 +1,125 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#include "crunch/concurrency/mpmc_bounded_queue.hpp"
+#include "crunch/concurrency/thread.hpp"
+#include "crunch/test/framework.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace Crunch { namespace Concurrency {
+
+BOOST_AUTO_TEST_SUITE(MPMCBoundedQueueTests)
+
+BOOST_AUTO_TEST_CASE(EmptyTest)
+{
+    MPMCBoundedQueue<int> queue(2);
+    BOOST_CHECK_EQUAL(queue.GetCapacity(), 4u);
+
+    int value;
+    BOOST_CHECK(!queue.TryPop(value));
+}
+
+BOOST_AUTO_TEST_CASE(FifoAndFullTest)
+{
+    MPMCBoundedQueue<int> queue(2);
+
+    // Go around the ring a few times
+    for (int lap = 0; lap < 3; ++lap)
+    {
+        for (int i = 0; i < 4; ++i)
+            BOOST_CHECK(queue.TryPush(i));
+
+        BOOST_CHECK(!queue.TryPush(4));
+
+        for (int i = 0; i < 4; ++i)
+        {
+            int value = -1;
+            BOOST_CHECK(queue.TryPop(value));
+            BOOST_CHECK_EQUAL(value, i);
+        }
+
+        int value;
+        BOOST_CHECK(!queue.TryPop(value));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(DestroysRemainingTest)
+{
+    std::shared_ptr<int> const item = std::make_shared<int>(0);
+    {
+        MPMCBoundedQueue<std::shared_ptr<int>> queue(3);
+        queue.TryPush(item);
+        queue.TryPush(item);
+        BOOST_CHECK_EQUAL(item.use_count(), 3);
+    }
+    BOOST_CHECK_EQUAL(item.use_count(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(ConcurrentTest)
+{
+    MPMCBoundedQueue<std::uint32_t> queue(6);
+
+    std::uint32_t const producerCount = 2;
+    std::uint32_t const consumerCount = 2;
+    std::uint32_t const itemsPerProducer = 50000;
+
+    std::vector<std::vector<std::uint32_t>> consumed(consumerCount);
+    Atomic<std::uint32_t> remaining(producerCount * itemsPerProducer);
+
+    std::vector<Thread> threads;
+    for (std::uint32_t p = 0; p < producerCount; ++p)
+    {
+        threads.push_back(Thread([&, p]
+        {
+            for (std::uint32_t i = 0; i < itemsPerProducer; ++i)
+                while (!queue.TryPush(p * itemsPerProducer + i));
+        }));
+    }
+
+    for (std::uint32_t c = 0; c < consumerCount; ++c)
+    {
+        threads.push_back(Thread([&, c]
+        {
+            std::uint32_t value;
+            while (remaining.Load(MEMORY_ORDER_RELAXED) != 0)
+            {
+                if (queue.TryPop(value))
+                {
+                    consumed[c].push_back(value);
+                    remaining.Decrement();
+                }
+            }
+        }));
+    }
+
+    std::for_each(threads.begin(), threads.end(), [] (Thread& t) { t.Join(); });
+
+    // Each consumer sees each producer's items in order, and every item exactly once overall
+    std::vector<std::uint32_t> all;
+    std::for_each(consumed.begin(), consumed.end(), [&] (std::vector<std::uint32_t> const& values)
+    {
+        std::vector<std::uint32_t> last(producerCount, 0);
+        std::vector<bool> seenAny(producerCount, false);
+        std::for_each(values.begin(), values.end(), [&] (std::uint32_t value)
+        {
+            std::uint32_t const producer = value / itemsPerProducer;
+            if (seenAny[producer])
+                BOOST_CHECK_GT(value, last[producer]);
+            seenAny[producer] = true;
+            last[producer] = value;
+        });
+        all.insert(all.end(), values.begin(), values.end());
+    });
+
+    std::sort(all.begin(), all.end());
+    BOOST_REQUIRE_EQUAL(all.size(), producerCount * itemsPerProducer);
+    for (std::uint32_t i = 0; i < all.size(); ++i)
+        BOOST_REQUIRE_EQUAL(all[i], i);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}}
@@ -0,0 +1,177 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#include "crunch/concurrency/mpmc_fifo_queue.hpp"
+#include "crunch/concurrency/thread.hpp"
+#include "crunch/test/framework.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace Crunch { namespace Concurrency {
+
+BOOST_AUTO_TEST_SUITE(MPMCFifoQueueTests)
+
+BOOST_AUTO_TEST_CASE(EmptyTest)
+{
+    MPMCFifoQueue<int> queue;
+
+    int value;
+    BOOST_CHECK(!queue.TryPop(value));
+}
+
+BOOST_AUTO_TEST_CASE(FifoAcrossSegmentsTest)
+{
+    MPMCFifoQueue<int, 4> queue;
+
+    for (int round = 0; round < 3; ++round)
+    {
+        for (int i = 0; i < 19; ++i)
+            queue.Push(i);
+
+        for (int i = 0; i < 19; ++i)
+        {
+            int value = -1;
+            BOOST_CHECK(queue.TryPop(value));
+            BOOST_CHECK_EQUAL(value, i);
+        }
+
+        int value;
+        BOOST_CHECK(!queue.TryPop(value));
+    }
+
+    // Drained segments are recycled once no thread can see them
+    Epoch::Quiesce();
+}
+
+BOOST_AUTO_TEST_CASE(DestroysRemainingTest)
+{
+    std::shared_ptr<int> const item = std::make_shared<int>(0);
+    {
+        MPMCFifoQueue<std::shared_ptr<int>, 2> queue;
+        for (int i = 0; i < 5; ++i)
+            queue.Push(item);
+
+        std::shared_ptr<int> value;
+        BOOST_CHECK(queue.TryPop(value));
+        value.reset();
+        BOOST_CHECK_EQUAL(item.use_count(), 5);
+    }
+    BOOST_CHECK_EQUAL(item.use_count(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(ConcurrentTest)
+{
+    MPMCFifoQueue<std::uint32_t, 16> queue;
+
+    std::uint32_t const producerCount = 2;
+    std::uint32_t const consumerCount = 2;
+    std::uint32_t const itemsPerProducer = 50000;
+
+    std::vector<std::vector<std::uint32_t>> consumed(consumerCount);
+    Atomic<std::uint32_t> remaining(producerCount * itemsPerProducer);
+
+    std::vector<Thread> threads;
+    for (std::uint32_t p = 0; p < producerCount; ++p)
+    {
+        threads.push_back(Thread([&, p]
+        {
+            for (std::uint32_t i = 0; i < itemsPerProducer; ++i)
+                queue.Push(p * itemsPerProducer + i);
+        }));
+    }
+
+    for (std::uint32_t c = 0; c < consumerCount; ++c)
+    {
+        threads.push_back(Thread([&, c]
+        {
+            std::uint32_t value;
+            while (remaining.Load(MEMORY_ORDER_RELAXED) != 0)
+            {
+                if (queue.TryPop(value))
+                {
+                    consumed[c].push_back(value);
+                    remaining.Decrement();
+                }
+            }
+        }));
+    }
+
+    std::for_each(threads.begin(), threads.end(), [] (Thread& t) { t.Join(); });
+
+    // Each consumer sees each producer's items in order, and every item exactly once overall
+    std::vector<std::uint32_t> all;
+    std::for_each(consumed.begin(), consumed.end(), [&] (std::vector<std::uint32_t> const& values)
+    {
+        std::vector<std::uint32_t> last(producerCount, 0);
+        std::vector<bool> seenAny(producerCount, false);
+        std::for_each(values.begin(), values.end(), [&] (std::uint32_t value)
+        {
+            std::uint32_t const producer = value / itemsPerProducer;
+            if (seenAny[producer])
+                BOOST_CHECK_GT(value, last[producer]);
+            seenAny[producer] = true;
+            last[producer] = value;
+        });
+        all.insert(all.end(), values.begin(), values.end());
+    });
+
+    std::sort(all.begin(), all.end());
+    BOOST_REQUIRE_EQUAL(all.size(), producerCount * itemsPerProducer);
+    for (std::uint32_t i = 0; i < all.size(); ++i)
+        BOOST_REQUIRE_EQUAL(all[i], i);
+}
+
+BOOST_AUTO_TEST_CASE(SegmentTurnoverTest)
+{
+    // Tiny segments so that segments are linked and retired while enqueuers may still hold the old tail
+    MPMCFifoQueue<std::uint32_t, 2> queue;
+
+    std::uint32_t const producerCount = 4;
+    std::uint32_t const consumerCount = 4;
+    std::uint32_t const itemsPerProducer = 100000;
+
+    Atomic<std::uint32_t> popped(0);
+    Atomic<std::uint64_t> poppedSum(0);
+
+    std::vector<Thread> threads;
+    for (std::uint32_t p = 0; p < producerCount; ++p)
+    {
+        threads.push_back(Thread([&, p]
+        {
+            for (std::uint32_t i = 0; i < itemsPerProducer; ++i)
+                queue.Push(p * itemsPerProducer + i);
+        }));
+    }
+
+    for (std::uint32_t c = 0; c < consumerCount; ++c)
+    {
+        threads.push_back(Thread([&]
+        {
+            std::uint32_t value;
+            while (popped.Load(MEMORY_ORDER_RELAXED) != producerCount * itemsPerProducer)
+            {
+                if (queue.TryPop(value))
+                {
+                    poppedSum.Add(value);
+                    popped.Increment();
+                }
+            }
+        }));
+    }
+
+    std::for_each(threads.begin(), threads.end(), [] (Thread& t) { t.Join(); });
+
+    std::uint64_t const pushedCount = producerCount * itemsPerProducer;
+    BOOST_CHECK_EQUAL(popped.Load(), pushedCount);
+    BOOST_CHECK_EQUAL(poppedSum.Load(), pushedCount * (pushedCount - 1) / 2);
+
+    std::uint32_t value;
+    BOOST_CHECK(!queue.TryPop(value));
+    Epoch::Quiesce();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}}
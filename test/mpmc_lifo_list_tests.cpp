@@ -2,8 +2,12 @@
 // Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
 
 #include "crunch/concurrency/mpmc_lifo_list.hpp"
+#include "crunch/concurrency/thread.hpp"
 #include "crunch/test/framework.hpp"
 
+#include <algorithm>
+#include <vector>
+
 namespace Crunch { namespace Concurrency {
 
 namespace
@@ -32,6 +36,21 @@ BOOST_AUTO_TEST_CASE(InitialStateTest)
     BOOST_CHECK_EQUAL(list.Pop(), (TestNode*)0);
 }
 
+BOOST_AUTO_TEST_CASE(NoEliminationSizeTest)
+{
+    // Backoff policies that never eliminate add nothing to the list
+    typedef PackedTaggedPointerPolicy::Root<TestNode>::ValueType PackedRoot;
+    typedef DoubleWidthTaggedPointerPolicy::Root<TestNode>::ValueType DoubleWidthRoot;
+    typedef MPMCLifoList<
+        TestNode,
+        ExponentialBackoff,
+        ReclamationPolicyAccessViolationChecked,
+        DoubleWidthTaggedPointerPolicy> DoubleWidthList;
+
+    BOOST_CHECK_EQUAL(sizeof(MPMCLifoList<TestNode>), sizeof(Atomic<PackedRoot>));
+    BOOST_CHECK_EQUAL(sizeof(DoubleWidthList), sizeof(Atomic<DoubleWidthRoot>));
+}
+
 BOOST_AUTO_TEST_CASE(SinglePushPopoTest)
 {
     MPMCLifoList<TestNode> list;
@@ -58,6 +77,203 @@ BOOST_AUTO_TEST_CASE(MultiPushPopTest)
     BOOST_CHECK_EQUAL(list.Pop(), (TestNode*)0);
 }
 
+BOOST_AUTO_TEST_CASE(PushChainPopAllTest)
+{
+    MPMCLifoList<TestNode> list;
+    BOOST_CHECK_EQUAL(list.PopAll(), (TestNode*)0);
+
+    TestNode n[5];
+    list.Push(n + 0);
+
+    // Chain is n[4] -> n[3] -> ... -> n[1]
+    for (int i = 4; i > 1; --i)
+        n[i].next = n + i - 1;
+    list.PushChain(n + 4, n + 1);
+
+    for (int i = 4; i >= 2; --i)
+        BOOST_CHECK_EQUAL(list.Pop(), n + i);
+
+    TestNode* const all = list.PopAll();
+    BOOST_CHECK_EQUAL(all, n + 1);
+    BOOST_CHECK_EQUAL(all->next, n + 0);
+    BOOST_CHECK_EQUAL(n[0].next, (TestNode*)0);
+    BOOST_CHECK_EQUAL(list.Pop(), (TestNode*)0);
+}
+
+BOOST_AUTO_TEST_CASE(DoubleWidthMultiPushPopTest)
+{
+    MPMCLifoList<TestNode, ExponentialBackoff, ReclamationPolicyNone, DoubleWidthTaggedPointerPolicy> list;
+
+    TestNode n[5];
+    for (int i = 0; i < 5; ++i)
+        list.Push(n + i);
+
+    for (int i = 4; i >= 0; --i)
+        BOOST_CHECK_EQUAL(list.Pop(), n + i);
+
+    BOOST_CHECK_EQUAL(list.Pop(), (TestNode*)0);
+}
+
+BOOST_AUTO_TEST_CASE(DoubleWidthConcurrentPushPopTest)
+{
+    MPMCLifoList<TestNode, ExponentialBackoff, ReclamationPolicyNone, DoubleWidthTaggedPointerPolicy> list;
+
+    int const threadCount = 4;
+    int const nodesPerThread = 1000;
+    std::vector<TestNode> nodes(threadCount * nodesPerThread);
+
+    std::vector<Thread> threads;
+    for (int t = 0; t < threadCount; ++t)
+    {
+        threads.push_back(Thread([&, t]
+        {
+            TestNode* const first = &nodes[t * nodesPerThread];
+            for (int i = 0; i < nodesPerThread; ++i)
+                list.Push(first + i);
+
+            // Keep nodes moving to exercise ABA
+            for (int i = 0; i < 10000; ++i)
+                if (TestNode* node = list.Pop())
+                    list.Push(node);
+        }));
+    }
+
+    std::for_each(threads.begin(), threads.end(), [] (Thread& t) { t.Join(); });
+
+    std::size_t count = 0;
+    while (list.Pop())
+        count++;
+
+    BOOST_CHECK_EQUAL(count, nodes.size());
+}
+
+BOOST_AUTO_TEST_CASE(EliminationExchangeTest)
+{
+    typedef EliminationBackoffT<1, 100000> BackoffType;
+    Detail::EliminationArray<BackoffType, TestNode> elimination;
+
+    // No partner, so offers are withdrawn
+    TestNode node;
+    BackoffType pushBackoff;
+    BOOST_CHECK(!elimination.TryEliminatePush(pushBackoff, &node));
+    BackoffType popBackoff;
+    BOOST_CHECK_EQUAL(elimination.TryEliminatePop(popBackoff), (TestNode*)0);
+
+    // Exchange with a partner
+    for (int i = 0; i < 10; ++i)
+    {
+        Atomic<TestNode*> received(nullptr);
+        Thread popper([&]
+        {
+            BackoffType backoff;
+            TestNode* result;
+            while ((result = elimination.TryEliminatePop(backoff)) == nullptr);
+            received.Store(result);
+        });
+
+        BackoffType backoff;
+        while (!elimination.TryEliminatePush(backoff, &node));
+
+        popper.Join();
+        BOOST_CHECK_EQUAL(received.Load(), &node);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(EliminationConcurrentPushPopTest)
+{
+    MPMCLifoList<TestNode, EliminationBackoff> list;
+
+    int const threadCount = 4;
+    int const nodesPerThread = 100;
+    std::vector<TestNode> nodes(threadCount * nodesPerThread);
+    Atomic<std::uint32_t> popped(0);
+
+    std::vector<Thread> threads;
+    for (int t = 0; t < threadCount; ++t)
+    {
+        threads.push_back(Thread([&, t]
+        {
+            // Mixed pushes and pops so colliding operations may eliminate each other
+            std::vector<TestNode*> owned;
+            for (int i = 0; i < nodesPerThread; ++i)
+                owned.push_back(&nodes[t * nodesPerThread + i]);
+
+            for (int round = 0; round < 1000; ++round)
+            {
+                while (!owned.empty())
+                {
+                    list.Push(owned.back());
+                    owned.pop_back();
+                }
+
+                for (int i = 0; i < nodesPerThread; ++i)
+                {
+                    if (TestNode* node = list.Pop())
+                        owned.push_back(node);
+                }
+            }
+
+            while (!owned.empty())
+            {
+                list.Push(owned.back());
+                owned.pop_back();
+            }
+        }));
+    }
+
+    std::for_each(threads.begin(), threads.end(), [] (Thread& t) { t.Join(); });
+
+    // Every node must be in the list exactly once
+    std::vector<bool> seen(nodes.size(), false);
+    while (TestNode* node = list.Pop())
+    {
+        std::size_t const index = node - &nodes[0];
+        BOOST_REQUIRE_LT(index, nodes.size());
+        BOOST_CHECK(!seen[index]);
+        seen[index] = true;
+        popped.Increment();
+    }
+
+    BOOST_CHECK_EQUAL(popped.Load(), nodes.size());
+}
+
+template<typename ReclamationPolicy>
+void TestReclamation()
+{
+    MPMCLifoList<TestNode, ExponentialBackoff, ReclamationPolicy> list;
+
+    // Every thread pops nodes and frees them while others may still be reading them in Pop
+    auto worker = [&]
+    {
+        for (int i = 0; i < 10000; ++i)
+        {
+            list.Push(new TestNode());
+            if (TestNode* node = list.Pop())
+                ReclamationPolicy::Retire(node);
+        }
+    };
+
+    std::vector<Thread> threads;
+    for (int i = 0; i < 4; ++i)
+        threads.push_back(Thread(worker));
+
+    std::for_each(threads.begin(), threads.end(), [] (Thread& t) { t.Join(); });
+
+    while (TestNode* node = list.Pop())
+        ReclamationPolicy::Retire(node);
+}
+
+BOOST_AUTO_TEST_CASE(HazardPointerReclamationTest)
+{
+    TestReclamation<ReclamationPolicyHazardPointer>();
+    HazardPointer::ReclaimAll();
+}
+
+BOOST_AUTO_TEST_CASE(EpochReclamationTest)
+{
+    TestReclamation<ReclamationPolicyEpoch>();
+    Epoch::Quiesce();
+}
 
 BOOST_AUTO_TEST_SUITE_END()
 
@@ -0,0 +1,130 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#include "crunch/concurrency/mpsc_fifo_list.hpp"
+#include "crunch/concurrency/thread.hpp"
+#include "crunch/test/framework.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace Crunch { namespace Concurrency {
+
+namespace
+{
+    struct TestNode
+    {
+        TestNode() : next(nullptr), value(0) {}
+
+        TestNode* next;
+        std::uint32_t value;
+    };
+
+    void SetNext(TestNode& node, TestNode* next)
+    {
+        node.next = next;
+    }
+
+    TestNode* GetNext(TestNode const& node)
+    {
+        return node.next;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(MPSCFifoListTests)
+
+BOOST_AUTO_TEST_CASE(InitialStateTest)
+{
+    MPSCFifoList<TestNode> list;
+    BOOST_CHECK(list.IsEmpty());
+    BOOST_CHECK_EQUAL(list.Pop(), (TestNode*)0);
+}
+
+BOOST_AUTO_TEST_CASE(FifoTest)
+{
+    MPSCFifoList<TestNode> list;
+    TestNode nodes[4];
+
+    // Drain completely in between to cycle the stub through the list
+    for (int round = 0; round < 3; ++round)
+    {
+        for (int i = 0; i < 4; ++i)
+            list.Push(&nodes[i]);
+
+        BOOST_CHECK(!list.IsEmpty());
+
+        for (int i = 0; i < 4; ++i)
+            BOOST_CHECK_EQUAL(list.Pop(), &nodes[i]);
+
+        BOOST_CHECK(list.IsEmpty());
+        BOOST_CHECK_EQUAL(list.Pop(), (TestNode*)0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(NotEmptyConditionTest)
+{
+    MPSCFifoList<TestNode> list;
+    IWaitable& notEmpty = list.GetNotEmptyCondition();
+
+    volatile std::uint32_t wakeupCount = 0;
+    BOOST_CHECK(notEmpty.AddWaiter([&] { wakeupCount++; }));
+
+    TestNode node;
+    list.Push(&node);
+    BOOST_CHECK_EQUAL(wakeupCount, 1u);
+    BOOST_CHECK(!notEmpty.AddWaiter([&] { wakeupCount++; }));
+
+    BOOST_CHECK_EQUAL(list.Pop(), &node);
+    BOOST_CHECK(notEmpty.AddWaiter([&] { wakeupCount++; }));
+    list.Push(&node);
+    BOOST_CHECK_EQUAL(wakeupCount, 2u);
+}
+
+BOOST_AUTO_TEST_CASE(ConcurrentTest)
+{
+    MPSCFifoList<TestNode> list;
+
+    std::uint32_t const producerCount = 3;
+    std::uint32_t const nodesPerProducer = 50000;
+    std::vector<TestNode> nodes(producerCount * nodesPerProducer);
+    for (std::uint32_t i = 0; i < nodes.size(); ++i)
+        nodes[i].value = i;
+
+    std::vector<Thread> producers;
+    for (std::uint32_t p = 0; p < producerCount; ++p)
+    {
+        producers.push_back(Thread([&, p]
+        {
+            for (std::uint32_t i = 0; i < nodesPerProducer; ++i)
+                list.Push(&nodes[p * nodesPerProducer + i]);
+        }));
+    }
+
+    // Consumer parks whenever the list looks empty
+    std::vector<std::uint32_t> last(producerCount, 0);
+    std::vector<bool> seenAny(producerCount, false);
+    std::uint32_t received = 0;
+    while (received != nodes.size())
+    {
+        TestNode* const node = list.Pop();
+        if (node == nullptr)
+        {
+            WaitFor(list.GetNotEmptyCondition(), WaitMode::Block());
+            continue;
+        }
+
+        std::uint32_t const producer = node->value / nodesPerProducer;
+        if (seenAny[producer])
+            BOOST_REQUIRE_GT(node->value, last[producer]);
+        seenAny[producer] = true;
+        last[producer] = node->value;
+        ++received;
+    }
+
+    std::for_each(producers.begin(), producers.end(), [] (Thread& t) { t.Join(); });
+    BOOST_CHECK(list.IsEmpty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}}
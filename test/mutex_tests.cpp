@@ -2,8 +2,12 @@
 // Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
 
 #include "crunch/concurrency/mutex.hpp"
+#include "crunch/concurrency/thread.hpp"
 #include "crunch/test/framework.hpp"
 
+#include <algorithm>
+#include <vector>
+
 namespace Crunch { namespace Concurrency {
 
 BOOST_AUTO_TEST_SUITE(MutexTests)
@@ -69,6 +73,90 @@ BOOST_AUTO_TEST_CASE(RemoveWaiterTest)
     waiter->Destroy();
 }
 
+BOOST_AUTO_TEST_CASE(FairAddWaiterToLockedTest)
+{
+    Mutex m(0, Mutex::MODE_FAIR);
+    volatile bool called1 = false;
+    volatile bool called2 = false;
+    volatile bool called3 = false;
+    volatile bool called4 = false;
+    BOOST_CHECK(!m.AddWaiter([&] { called1 = true; }));
+    BOOST_CHECK(m.AddWaiter([&] { called2 = true; }));
+    BOOST_CHECK(m.AddWaiter([&] { called3 = true; }));
+    BOOST_CHECK(m.AddWaiter([&] { called4 = true; }));
+    m.Unlock();
+    BOOST_CHECK(called2);
+    BOOST_CHECK(!called3);
+    BOOST_CHECK(!called4);
+    BOOST_CHECK(m.IsLocked());
+    m.Unlock();
+    BOOST_CHECK(called3);
+    BOOST_CHECK(!called4);
+    BOOST_CHECK(m.IsLocked());
+
+    // Free mutex can't be taken while anyone is waiting
+    volatile bool called5 = false;
+    BOOST_CHECK(m.AddWaiter([&] { called5 = true; }));
+    m.Unlock();
+    BOOST_CHECK(called4);
+    BOOST_CHECK(!called5);
+    m.Unlock();
+    BOOST_CHECK(called5);
+    BOOST_CHECK(m.IsLocked());
+    m.Unlock();
+    BOOST_CHECK(!m.IsLocked());
+}
+
+BOOST_AUTO_TEST_CASE(FairRemoveWaiterTest)
+{
+    Mutex m(0, Mutex::MODE_FAIR);
+    volatile bool called2 = false;
+    volatile bool called3 = false;
+    volatile bool called4 = false;
+
+    auto waiter = Waiter::Create([&] { called2 = true; }, false);
+    BOOST_CHECK(!m.AddWaiter([] {}));
+    BOOST_CHECK(m.AddWaiter(waiter));
+    BOOST_CHECK(m.AddWaiter([&] { called3 = true; }));
+    BOOST_CHECK(m.AddWaiter([&] { called4 = true; }));
+    BOOST_CHECK(m.RemoveWaiter(waiter));
+    m.Unlock();
+    BOOST_CHECK(!called2);
+    BOOST_CHECK(called3);
+    BOOST_CHECK(!called4);
+    m.Unlock();
+    BOOST_CHECK(called4);
+    m.Unlock();
+    BOOST_CHECK(!m.IsLocked());
+    waiter->Destroy();
+}
+
+BOOST_AUTO_TEST_CASE(AdaptiveSpinContentionTest)
+{
+    Mutex m(Mutex::ADAPTIVE_SPIN);
+    std::uint32_t const threadCount = 4;
+    std::uint32_t const iterationCount = 20000;
+    std::uint32_t counter = 0;
+
+    std::vector<Thread> threads;
+    for (std::uint32_t t = 0; t < threadCount; ++t)
+    {
+        threads.push_back(Thread([&]
+        {
+            for (std::uint32_t i = 0; i < iterationCount; ++i)
+            {
+                m.Lock();
+                counter++;
+                m.Unlock();
+            }
+        }));
+    }
+
+    std::for_each(threads.begin(), threads.end(), [] (Thread& t) { t.Join(); });
+    BOOST_CHECK_EQUAL(counter, threadCount * iterationCount);
+    BOOST_CHECK(!m.IsLocked());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }}
@@ -0,0 +1,151 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#include "crunch/concurrency/queue_mutex.hpp"
+#include "crunch/concurrency/thread.hpp"
+#include "crunch/test/framework.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace Crunch { namespace Concurrency {
+
+BOOST_AUTO_TEST_SUITE(QueueMutexTests)
+
+BOOST_AUTO_TEST_CASE(ConstructTest)
+{
+    QueueMutex m;
+    BOOST_CHECK(!m.IsLocked());
+}
+
+BOOST_AUTO_TEST_CASE(LockUnlockTest)
+{
+    QueueMutex m;
+    m.Lock();
+    BOOST_CHECK(m.IsLocked());
+    m.Unlock();
+    BOOST_CHECK(!m.IsLocked());
+}
+
+BOOST_AUTO_TEST_CASE(AddWaiterToUnlockedTest)
+{
+    QueueMutex m;
+    volatile bool called = false;
+    BOOST_CHECK(!m.AddWaiter([&] { called = true; }));
+    BOOST_CHECK(!called);
+    BOOST_CHECK(m.IsLocked());
+    m.Unlock();
+    BOOST_CHECK(!m.IsLocked());
+}
+
+BOOST_AUTO_TEST_CASE(AddWaiterToLockedTest)
+{
+    QueueMutex m;
+    volatile bool called1 = false;
+    volatile bool called2 = false;
+    volatile bool called3 = false;
+    BOOST_CHECK(!m.AddWaiter([&] { called1 = true; }));
+    BOOST_CHECK(m.AddWaiter([&] { called2 = true; }));
+    BOOST_CHECK(m.AddWaiter([&] { called3 = true; }));
+    BOOST_CHECK(!called1);
+    BOOST_CHECK(!called2);
+    BOOST_CHECK(!called3);
+    m.Unlock();
+    BOOST_CHECK(called2);
+    BOOST_CHECK(!called3);
+    BOOST_CHECK(m.IsLocked());
+    m.Unlock();
+    BOOST_CHECK(called3);
+    BOOST_CHECK(m.IsLocked());
+    m.Unlock();
+    BOOST_CHECK(!m.IsLocked());
+}
+
+BOOST_AUTO_TEST_CASE(RemoveWaiterTest)
+{
+    QueueMutex m;
+    volatile bool called2 = false;
+    volatile bool called3 = false;
+
+    auto waiter = Waiter::Create([&] { called2 = true; }, false);
+    m.Lock();
+    BOOST_CHECK(m.AddWaiter(waiter));
+    BOOST_CHECK(m.AddWaiter([&] { called3 = true; }));
+    BOOST_CHECK(m.RemoveWaiter(waiter));
+
+    // Withdrawn waiter is skipped
+    m.Unlock();
+    BOOST_CHECK(!called2);
+    BOOST_CHECK(called3);
+    m.Unlock();
+    BOOST_CHECK(!m.IsLocked());
+
+    // Can't withdraw once handed the lock
+    BOOST_CHECK(!m.AddWaiter(waiter));
+    BOOST_CHECK(!m.RemoveWaiter(waiter));
+    m.Unlock();
+    waiter->Destroy();
+}
+
+BOOST_AUTO_TEST_CASE(ContentionTest)
+{
+    QueueMutex m(10);
+    std::uint32_t const threadCount = 4;
+    std::uint32_t const iterationCount = 20000;
+    std::uint32_t counter = 0;
+
+    std::vector<Thread> threads;
+    for (std::uint32_t t = 0; t < threadCount; ++t)
+    {
+        threads.push_back(Thread([&, t]
+        {
+            for (std::uint32_t i = 0; i < iterationCount; ++i)
+            {
+                if ((i + t) % 4 == 0)
+                    WaitFor(m, WaitMode::Block());
+                else
+                    m.Lock();
+
+                counter++;
+                m.Unlock();
+            }
+        }));
+    }
+
+    std::for_each(threads.begin(), threads.end(), [] (Thread& t) { t.Join(); });
+    BOOST_CHECK_EQUAL(counter, threadCount * iterationCount);
+    BOOST_CHECK(!m.IsLocked());
+}
+
+BOOST_AUTO_TEST_CASE(ShortLivedThreadsTest)
+{
+    // Nodes cached by exited threads are handed on to later threads
+    QueueMutex m;
+    std::uint32_t counter = 0;
+
+    for (std::uint32_t round = 0; round < 100; ++round)
+    {
+        std::vector<Thread> threads;
+        for (std::uint32_t t = 0; t < 2; ++t)
+        {
+            threads.push_back(Thread([&]
+            {
+                for (std::uint32_t i = 0; i < 10; ++i)
+                {
+                    m.Lock();
+                    counter++;
+                    m.Unlock();
+                }
+            }));
+        }
+
+        std::for_each(threads.begin(), threads.end(), [] (Thread& t) { t.Join(); });
+    }
+
+    BOOST_CHECK_EQUAL(counter, 2000u);
+    BOOST_CHECK(!m.IsLocked());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}}
@@ -0,0 +1,168 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#include "crunch/concurrency/read_write_mutex.hpp"
+#include "crunch/concurrency/thread.hpp"
+#include "crunch/test/framework.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace Crunch { namespace Concurrency {
+
+BOOST_AUTO_TEST_SUITE(ReadWriteMutexTests)
+
+BOOST_AUTO_TEST_CASE(SharedLockTest)
+{
+    ReadWriteMutex m;
+    BOOST_CHECK(m.TryLockShared());
+    m.LockShared();
+    BOOST_CHECK(!m.IsWriterActive());
+    m.UnlockShared();
+    m.UnlockShared();
+
+    m.Lock();
+    BOOST_CHECK(m.IsWriterActive());
+    m.Unlock();
+    BOOST_CHECK(!m.IsWriterActive());
+}
+
+BOOST_AUTO_TEST_CASE(WriterBlocksReadersTest)
+{
+    ReadWriteMutex m;
+    volatile bool reader1 = false;
+    volatile bool reader2 = false;
+    volatile bool writer = false;
+
+    BOOST_CHECK(!m.AddWaiter([] {}));
+    BOOST_CHECK(!m.TryLockShared());
+    BOOST_CHECK(m.GetShared().AddWaiter([&] { reader1 = true; }));
+    BOOST_CHECK(m.GetShared().AddWaiter([&] { reader2 = true; }));
+    BOOST_CHECK(!reader1);
+    BOOST_CHECK(!reader2);
+
+    // Readers admitted together
+    m.Unlock();
+    BOOST_CHECK(reader1);
+    BOOST_CHECK(reader2);
+    BOOST_CHECK(!m.IsWriterActive());
+
+    // Writer waits for both to leave
+    BOOST_CHECK(m.AddWaiter([&] { writer = true; }));
+    m.UnlockShared();
+    BOOST_CHECK(!writer);
+    m.UnlockShared();
+    BOOST_CHECK(writer);
+    m.Unlock();
+}
+
+BOOST_AUTO_TEST_CASE(WriterPreferenceTest)
+{
+    ReadWriteMutex m;
+    volatile bool writer = false;
+    volatile bool reader = false;
+
+    m.LockShared();
+    BOOST_CHECK(m.AddWaiter([&] { writer = true; }));
+
+    // Pending writer turns new readers away
+    BOOST_CHECK(!m.TryLockShared());
+    BOOST_CHECK(m.GetShared().AddWaiter([&] { reader = true; }));
+
+    m.UnlockShared();
+    BOOST_CHECK(writer);
+    BOOST_CHECK(!reader);
+    m.Unlock();
+    BOOST_CHECK(reader);
+    m.UnlockShared();
+}
+
+BOOST_AUTO_TEST_CASE(RemoveWaiterTest)
+{
+    ReadWriteMutex m;
+    volatile bool called = false;
+
+    // Withdraw writer that is waiting for readers to leave
+    auto writer = Waiter::Create([&] { called = true; }, false);
+    m.LockShared();
+    BOOST_CHECK(m.AddWaiter(writer));
+    BOOST_CHECK(m.IsWriterActive());
+    BOOST_CHECK(m.RemoveWaiter(writer));
+    BOOST_CHECK(!m.IsWriterActive());
+    BOOST_CHECK(m.TryLockShared());
+    m.UnlockShared();
+    m.UnlockShared();
+    BOOST_CHECK(!called);
+
+    // Withdraw queued reader and writer
+    auto reader = Waiter::Create([&] { called = true; }, false);
+    m.Lock();
+    BOOST_CHECK(m.AddWaiter(writer));
+    BOOST_CHECK(m.GetShared().AddWaiter(reader));
+    BOOST_CHECK(m.RemoveWaiter(writer));
+    BOOST_CHECK(m.GetShared().RemoveWaiter(reader));
+    m.Unlock();
+    BOOST_CHECK(!called);
+    BOOST_CHECK(!m.IsWriterActive());
+
+    writer->Destroy();
+    reader->Destroy();
+}
+
+BOOST_AUTO_TEST_CASE(ContentionTest)
+{
+    ReadWriteMutex m;
+    std::uint32_t const threadCount = 6;
+    std::uint32_t const iterationCount = 20000;
+
+    Atomic<std::uint32_t> readerCount(0);
+    Atomic<std::uint32_t> writerCount(0);
+    std::uint32_t value1 = 0;
+    std::uint32_t value2 = 0;
+
+    std::vector<Thread> threads;
+    for (std::uint32_t t = 0; t < threadCount; ++t)
+    {
+        threads.push_back(Thread([&, t]
+        {
+            for (std::uint32_t i = 0; i < iterationCount; ++i)
+            {
+                if ((i + t) % 8 == 0)
+                {
+                    if (i % 2 == 0)
+                        m.Lock();
+                    else
+                        WaitFor(m, WaitMode::Block());
+
+                    BOOST_REQUIRE_EQUAL(writerCount.Increment(), 0u);
+                    BOOST_REQUIRE_EQUAL(readerCount.Load(), 0u);
+                    value1++;
+                    value2++;
+                    writerCount.Decrement();
+                    m.Unlock();
+                }
+                else
+                {
+                    if (i % 2 == 0)
+                        m.LockShared();
+                    else
+                        WaitFor(m.GetShared(), WaitMode::Block());
+
+                    readerCount.Increment();
+                    BOOST_REQUIRE_EQUAL(writerCount.Load(), 0u);
+                    BOOST_REQUIRE_EQUAL(value1, value2);
+                    readerCount.Decrement();
+                    m.UnlockShared();
+                }
+            }
+        }));
+    }
+
+    std::for_each(threads.begin(), threads.end(), [] (Thread& t) { t.Join(); });
+    BOOST_CHECK_EQUAL(value1, value2);
+    BOOST_CHECK(!m.IsWriterActive());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}}
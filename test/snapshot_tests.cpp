@@ -0,0 +1,178 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#include "crunch/concurrency/snapshot.hpp"
+#include "crunch/concurrency/thread.hpp"
+#include "crunch/concurrency/yield.hpp"
+#include "crunch/test/framework.hpp"
+
+#include "./tracked_object.hpp"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace Crunch { namespace Concurrency {
+
+namespace
+{
+    struct Config
+    {
+        std::string name;
+        std::vector<std::uint32_t> values;
+    };
+}
+
+BOOST_AUTO_TEST_SUITE(SnapshotTests)
+
+BOOST_AUTO_TEST_CASE(QuiescentReaderTest)
+{
+    Atomic<std::uint32_t> reclaimed(0);
+    Atomic<std::uint32_t> stage(0);
+
+    // A registered reader holds up reclamation only until its next quiescent state, not until it unregisters. Other
+    // thread registers before the object is retired, and doesn't quiesce until told to.
+    Thread reader([&]
+    {
+        GracePeriod::Reader const registration;
+        stage.Store(1);
+        while (stage.Load() != 2)
+            ThreadYield();
+
+        GracePeriod::Quiesce();
+        stage.Store(3);
+        while (stage.Load() != 4)
+            ThreadYield();
+    });
+
+    while (stage.Load() != 1)
+        ThreadYield();
+
+    GracePeriod::Retire(new TrackedObject(reclaimed));
+    for (int i = 0; i < 100; ++i)
+        GracePeriod::Quiesce();
+
+    BOOST_CHECK_EQUAL(reclaimed.Load(), 0u);
+
+    // Reclaimed once the reader reports a quiescent state, while it is still registered
+    stage.Store(2);
+    while (stage.Load() != 3)
+        ThreadYield();
+
+    QuiesceUntil<GracePeriod>(reclaimed, 1);
+    BOOST_CHECK_EQUAL(reclaimed.Load(), 1u);
+
+    stage.Store(4);
+    reader.Join();
+}
+
+BOOST_AUTO_TEST_CASE(OfflineReaderTest)
+{
+    Atomic<std::uint32_t> reclaimed(0);
+    Atomic<std::uint32_t> stage(0);
+
+    Thread reader([&]
+    {
+        GracePeriod::Reader const registration;
+        GracePeriod::Offline const outer;
+        {
+            GracePeriod::Offline const inner;
+        }
+
+        // Still offline after the nested scope ends
+        stage.Store(1);
+        while (stage.Load() != 2)
+            ThreadYield();
+    });
+
+    while (stage.Load() != 1)
+        ThreadYield();
+
+    GracePeriod::Retire(new TrackedObject(reclaimed));
+    QuiesceUntil<GracePeriod>(reclaimed, 1);
+    BOOST_CHECK_EQUAL(reclaimed.Load(), 1u);
+
+    stage.Store(2);
+    reader.Join();
+}
+
+BOOST_AUTO_TEST_CASE(PublishReadTest)
+{
+    GracePeriod::Reader const registration;
+
+    Config initial;
+    initial.name = "initial";
+    Snapshot<Config> snapshot(initial);
+
+    Config const* const first = snapshot.Get();
+    BOOST_CHECK_EQUAL(first->name, "initial");
+
+    snapshot.Update([] (Config& config)
+    {
+        config.name = "updated";
+        config.values.push_back(1);
+    });
+
+    // Old version stays valid until this thread quiesces
+    BOOST_CHECK_EQUAL(first->name, "initial");
+    BOOST_CHECK(first->values.empty());
+    BOOST_CHECK_EQUAL(snapshot.Get()->name, "updated");
+    BOOST_CHECK_EQUAL(snapshot.Get()->values.size(), 1u);
+
+    Config* const replacement = new Config();
+    replacement->name = "published";
+    snapshot.Publish(replacement);
+    BOOST_CHECK_EQUAL(snapshot.Get(), replacement);
+
+    GracePeriod::Quiesce();
+}
+
+BOOST_AUTO_TEST_CASE(ConcurrentReadUpdateTest)
+{
+    Snapshot<Config> snapshot;
+    std::uint32_t const updateCount = 5000;
+    volatile bool done = false;
+
+    // Every update writes the same value to all entries, so a version modified after publishing shows up as differing
+    // entries, and a reclaimed one as garbage
+    std::vector<Thread> readers;
+    for (int r = 0; r < 3; ++r)
+    {
+        readers.push_back(Thread([&]
+        {
+            GracePeriod::Reader const registration;
+            std::uint32_t lastValue = 0;
+            while (!done)
+            {
+                Config const* const config = snapshot.Get();
+                if (!config->values.empty())
+                {
+                    std::uint32_t const value = config->values.front();
+                    BOOST_REQUIRE(std::count(config->values.begin(), config->values.end(), value) == 16);
+                    BOOST_REQUIRE_GE(value, lastValue);
+                    lastValue = value;
+                }
+
+                GracePeriod::Quiesce();
+            }
+        }));
+    }
+
+    for (std::uint32_t u = 1; u <= updateCount; ++u)
+    {
+        snapshot.Update([u] (Config& config)
+        {
+            config.values.assign(16, u);
+        });
+    }
+
+    done = true;
+    std::for_each(readers.begin(), readers.end(), [] (Thread& t) { t.Join(); });
+
+    GracePeriod::Reader const registration;
+    BOOST_CHECK_EQUAL(snapshot.Get()->values.back(), updateCount);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}}
@@ -0,0 +1,139 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#include "crunch/concurrency/spsc_bounded_queue.hpp"
+#include "crunch/concurrency/thread.hpp"
+#include "crunch/test/framework.hpp"
+
+#include <iterator>
+#include <memory>
+#include <vector>
+
+namespace Crunch { namespace Concurrency {
+
+BOOST_AUTO_TEST_SUITE(SPSCBoundedQueueTests)
+
+BOOST_AUTO_TEST_CASE(FifoAndFullTest)
+{
+    SPSCBoundedQueue<int> queue(2);
+    BOOST_CHECK_EQUAL(queue.GetCapacity(), 4u);
+    BOOST_CHECK(queue.IsEmpty());
+
+    for (int lap = 0; lap < 3; ++lap)
+    {
+        for (int i = 0; i < 4; ++i)
+            BOOST_CHECK(queue.TryPush(i));
+
+        BOOST_CHECK(!queue.TryPush(4));
+        BOOST_CHECK(!queue.IsEmpty());
+
+        for (int i = 0; i < 4; ++i)
+        {
+            int value = -1;
+            BOOST_CHECK(queue.TryPop(value));
+            BOOST_CHECK_EQUAL(value, i);
+        }
+
+        int value;
+        BOOST_CHECK(!queue.TryPop(value));
+        BOOST_CHECK(queue.IsEmpty());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(BatchTest)
+{
+    SPSCBoundedQueue<int> queue(3);
+
+    std::vector<int> input;
+    for (int i = 0; i < 12; ++i)
+        input.push_back(i);
+
+    // Only room for 8
+    std::vector<int>::iterator const rest = queue.PushBatch(input.begin(), input.end());
+    BOOST_CHECK(rest == input.begin() + 8);
+
+    std::vector<int> output;
+    BOOST_CHECK_EQUAL(queue.PopBatch(std::back_inserter(output), 5), 5u);
+    BOOST_CHECK(queue.PushBatch(rest, input.end()) == input.end());
+    BOOST_CHECK_EQUAL(queue.PopBatch(std::back_inserter(output), 100), 7u);
+    BOOST_CHECK_EQUAL(queue.PopBatch(std::back_inserter(output), 100), 0u);
+
+    BOOST_CHECK(output == input);
+}
+
+BOOST_AUTO_TEST_CASE(DestroysRemainingTest)
+{
+    std::shared_ptr<int> const item = std::make_shared<int>(0);
+    {
+        SPSCBoundedQueue<std::shared_ptr<int>> queue(3);
+        queue.TryPush(item);
+        queue.TryPush(item);
+        BOOST_CHECK_EQUAL(item.use_count(), 3);
+    }
+    BOOST_CHECK_EQUAL(item.use_count(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(NotEmptyConditionTest)
+{
+    SPSCBoundedQueue<int> queue(2);
+    IWaitable& notEmpty = queue.GetNotEmptyCondition();
+    BOOST_CHECK(!notEmpty.IsOrderDependent());
+
+    volatile std::uint32_t wakeupCount = 0;
+    BOOST_CHECK(notEmpty.AddWaiter([&] { wakeupCount++; }));
+    BOOST_CHECK_EQUAL(wakeupCount, 0u);
+
+    BOOST_CHECK(queue.TryPush(1));
+    BOOST_CHECK_EQUAL(wakeupCount, 1u);
+
+    // Ready while not empty
+    BOOST_CHECK(!notEmpty.AddWaiter([&] { wakeupCount++; }));
+    BOOST_CHECK_EQUAL(wakeupCount, 1u);
+}
+
+BOOST_AUTO_TEST_CASE(ConcurrentWaitTest)
+{
+    SPSCBoundedQueue<std::uint32_t> queue(4);
+    std::uint32_t const itemCount = 200000;
+
+    Thread producer([&]
+    {
+        std::uint32_t batch[7];
+        for (std::uint32_t i = 0; i < itemCount;)
+        {
+            // Alternate single and batched pushes
+            if (i % 2 == 0)
+            {
+                if (queue.TryPush(i))
+                    ++i;
+            }
+            else
+            {
+                std::uint32_t count = 0;
+                for (; count < 7 && i + count < itemCount; ++count)
+                    batch[count] = i + count;
+                i += static_cast<std::uint32_t>(queue.PushBatch(batch, batch + count) - batch);
+            }
+        }
+    });
+
+    std::vector<std::uint32_t> received;
+    received.reserve(itemCount);
+    std::uint32_t buffer[5];
+    while (received.size() != itemCount)
+    {
+        WaitFor(queue.GetNotEmptyCondition(), WaitMode::Block());
+        std::size_t const count = queue.PopBatch(buffer, 5);
+        BOOST_REQUIRE_NE(count, 0u);
+        received.insert(received.end(), buffer, buffer + count);
+    }
+
+    producer.Join();
+
+    for (std::uint32_t i = 0; i < itemCount; ++i)
+        BOOST_REQUIRE_EQUAL(received[i], i);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}}
@@ -0,0 +1,50 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#include "crunch/concurrency/detail/system_event.hpp"
+#include "crunch/concurrency/thread.hpp"
+#include "crunch/test/framework.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace Crunch { namespace Concurrency {
+
+BOOST_AUTO_TEST_SUITE(SystemEventTests)
+
+BOOST_AUTO_TEST_CASE(InitiallySetTest)
+{
+    Detail::SystemEvent event(true);
+    event.Wait();
+    event.Reset();
+    event.Set();
+    event.Wait();
+}
+
+BOOST_AUTO_TEST_CASE(SetWakesAllTest)
+{
+    for (int round = 0; round < 20; ++round)
+    {
+        Detail::SystemEvent event;
+        Atomic<std::uint32_t> woken(0);
+
+        std::vector<Thread> threads;
+        for (int t = 0; t < 4; ++t)
+        {
+            threads.push_back(Thread([&]
+            {
+                event.Wait();
+                woken.Increment();
+            }));
+        }
+
+        BOOST_CHECK_EQUAL(woken.Load(), 0u);
+        event.Set();
+        std::for_each(threads.begin(), threads.end(), [] (Thread& t) { t.Join(); });
+        BOOST_CHECK_EQUAL(woken.Load(), 4u);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}}
@@ -0,0 +1,116 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#include "crunch/concurrency/detail/system_condition.hpp"
+#include "crunch/concurrency/detail/system_mutex.hpp"
+#include "crunch/concurrency/thread.hpp"
+#include "crunch/test/framework.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace Crunch { namespace Concurrency {
+
+BOOST_AUTO_TEST_SUITE(SystemMutexTests)
+
+BOOST_AUTO_TEST_CASE(TryLockTest)
+{
+    Detail::SystemMutex mutex;
+    BOOST_CHECK(mutex.TryLock());
+    BOOST_CHECK(!mutex.TryLock());
+    mutex.Unlock();
+    BOOST_CHECK(mutex.TryLock());
+    mutex.Unlock();
+}
+
+BOOST_AUTO_TEST_CASE(MutualExclusionTest)
+{
+    Detail::SystemMutex mutex;
+    std::uint32_t const threadCount = 4;
+    std::uint32_t const iterations = 50000;
+    std::uint32_t counter = 0;
+
+    std::vector<Thread> threads;
+    for (std::uint32_t t = 0; t < threadCount; ++t)
+    {
+        threads.push_back(Thread([&]
+        {
+            for (std::uint32_t i = 0; i < iterations; ++i)
+            {
+                Detail::SystemMutex::ScopedLock const lock(mutex);
+                counter++;
+            }
+        }));
+    }
+
+    std::for_each(threads.begin(), threads.end(), [] (Thread& t) { t.Join(); });
+    BOOST_CHECK_EQUAL(counter, threadCount * iterations);
+}
+
+BOOST_AUTO_TEST_CASE(ConditionWakeAllTest)
+{
+    Detail::SystemMutex mutex;
+    Detail::SystemCondition condition;
+    std::uint32_t const threadCount = 4;
+    std::uint32_t generation = 0;
+    std::uint32_t woken = 0;
+
+    // Waiters requeued onto the mutex by WakeAll must all get through
+    for (std::uint32_t round = 1; round <= 20; ++round)
+    {
+        std::vector<Thread> threads;
+        for (std::uint32_t t = 0; t < threadCount; ++t)
+        {
+            threads.push_back(Thread([&, round]
+            {
+                Detail::SystemMutex::ScopedLock const lock(mutex);
+                while (generation != round)
+                    condition.Wait(mutex);
+                woken++;
+            }));
+        }
+
+        {
+            Detail::SystemMutex::ScopedLock const lock(mutex);
+            generation = round;
+            condition.WakeAll();
+        }
+
+        std::for_each(threads.begin(), threads.end(), [] (Thread& t) { t.Join(); });
+    }
+
+    BOOST_CHECK_EQUAL(woken, threadCount * 20);
+}
+
+BOOST_AUTO_TEST_CASE(ConditionWakeOneTest)
+{
+    Detail::SystemMutex mutex;
+    Detail::SystemCondition condition;
+    std::uint32_t const itemCount = 10000;
+    std::uint32_t available = 0;
+
+    Thread consumer([&]
+    {
+        for (std::uint32_t i = 0; i < itemCount; ++i)
+        {
+            Detail::SystemMutex::ScopedLock const lock(mutex);
+            while (available == 0)
+                condition.Wait(mutex);
+            available--;
+        }
+    });
+
+    for (std::uint32_t i = 0; i < itemCount; ++i)
+    {
+        Detail::SystemMutex::ScopedLock const lock(mutex);
+        available++;
+        condition.WakeOne();
+    }
+
+    consumer.Join();
+    BOOST_CHECK_EQUAL(available, 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}}
@@ -0,0 +1,139 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#include "crunch/concurrency/detail/system_semaphore.hpp"
+#include "crunch/concurrency/thread.hpp"
+#include "crunch/concurrency/yield.hpp"
+#include "crunch/test/framework.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace Crunch { namespace Concurrency {
+
+BOOST_AUTO_TEST_SUITE(SystemSemaphoreTests)
+
+BOOST_AUTO_TEST_CASE(CountTest)
+{
+    Detail::SystemSemaphore s(2);
+    BOOST_CHECK(s.TryWait());
+    BOOST_CHECK(s.TryWait());
+    BOOST_CHECK(!s.TryWait());
+
+    s.Post();
+    s.Wait();
+    BOOST_CHECK(!s.TryWait());
+}
+
+BOOST_AUTO_TEST_CASE(PingPongTest)
+{
+    Detail::SystemSemaphore ping(0);
+    Detail::SystemSemaphore pong(0);
+    int const roundTrips = 10000;
+
+    Thread thread([&]
+    {
+        for (int i = 0; i < roundTrips; ++i)
+        {
+            ping.Wait();
+            pong.Post();
+        }
+    });
+
+    for (int i = 0; i < roundTrips; ++i)
+    {
+        ping.Post();
+        pong.Wait();
+    }
+
+    thread.Join();
+    BOOST_CHECK(!ping.TryWait());
+    BOOST_CHECK(!pong.TryWait());
+}
+
+BOOST_AUTO_TEST_CASE(MultipleSleepersTest)
+{
+    Detail::SystemSemaphore s(0);
+    Atomic<std::uint32_t> acquired(0);
+    std::uint32_t const threadCount = 4;
+    std::uint32_t const waitsPerThread = 1000;
+
+    std::vector<Thread> threads;
+    for (std::uint32_t t = 0; t < threadCount; ++t)
+    {
+        threads.push_back(Thread([&]
+        {
+            for (std::uint32_t i = 0; i < waitsPerThread; ++i)
+            {
+                s.Wait();
+                acquired.Increment();
+            }
+        }));
+    }
+
+    for (std::uint32_t i = 0; i < threadCount * waitsPerThread; ++i)
+        s.Post();
+
+    std::for_each(threads.begin(), threads.end(), [] (Thread& t) { t.Join(); });
+    BOOST_CHECK_EQUAL(acquired.Load(), threadCount * waitsPerThread);
+    BOOST_CHECK(!s.TryWait());
+}
+
+BOOST_AUTO_TEST_CASE(TimedWaitTest)
+{
+    Detail::SystemSemaphore s(1);
+    BOOST_CHECK(s.Wait(Duration::Milliseconds(10)));
+    BOOST_CHECK(!s.Wait(Duration::Milliseconds(10)));
+    BOOST_CHECK(!s.Wait(Duration::Zero));
+    BOOST_CHECK(!s.SpinWait(100, Duration::Milliseconds(1)));
+
+    // Post arrives while sleeping
+    Thread thread([&]
+    {
+        ThreadSleep(Duration::Milliseconds(20));
+        s.Post();
+    });
+
+    BOOST_CHECK(s.Wait(Duration::Seconds(10)));
+    thread.Join();
+
+    // Timed out wait doesn't consume a later post
+    BOOST_CHECK(!s.Wait(Duration::Milliseconds(1)));
+    s.Post();
+    BOOST_CHECK(s.TryWait());
+}
+
+BOOST_AUTO_TEST_CASE(DestroyAfterWaitTest)
+{
+    // The waiter destroys each semaphore as soon as it's acquired, possibly before Post has returned
+    int const rounds = 10000;
+    Atomic<Detail::SystemSemaphore*> current(nullptr);
+
+    Thread thread([&]
+    {
+        for (int i = 0; i < rounds; ++i)
+        {
+            Detail::SystemSemaphore* s;
+            while ((s = current.Load()) == nullptr)
+                CRUNCH_PAUSE();
+            current.Store(nullptr);
+            s->Post();
+        }
+    });
+
+    for (int i = 0; i < rounds; ++i)
+    {
+        Detail::SystemSemaphore s(0);
+        current.Store(&s);
+        if (i % 2)
+            s.SpinWait(100);
+        else
+            s.Wait();
+    }
+
+    thread.Join();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}}
@@ -0,0 +1,235 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#include "crunch/concurrency/event.hpp"
+#include "crunch/concurrency/meta_scheduler.hpp"
+#include "crunch/concurrency/mutex.hpp"
+#include "crunch/concurrency/task_scheduler.hpp"
+#include "crunch/concurrency/thread.hpp"
+#include "crunch/concurrency/yield.hpp"
+#include "crunch/test/framework.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace Crunch { namespace Concurrency {
+
+BOOST_AUTO_TEST_SUITE(TaskSchedulerTests)
+
+BOOST_AUTO_TEST_CASE(RunOnCurrentThreadTest)
+{
+    TaskScheduler scheduler;
+    ISchedulerContext& context = scheduler.GetContext();
+    BOOST_CHECK_EQUAL(&context, &scheduler.GetContext());
+
+    Future<int> f = scheduler.Post([] { return 123; });
+    BOOST_CHECK(!f.IsReady());
+
+    NullThrottler throttler;
+    BOOST_CHECK(context.Run(throttler) == ISchedulerContext::State::Idle);
+    BOOST_CHECK(f.IsReady());
+    BOOST_CHECK_EQUAL(f.Get(), 123);
+}
+
+BOOST_AUTO_TEST_CASE(ExceptionTest)
+{
+    TaskScheduler scheduler;
+    Future<void> f = scheduler.Post([] { throw std::runtime_error("test"); });
+
+    NullThrottler throttler;
+    scheduler.GetContext().Run(throttler);
+    BOOST_CHECK(f.HasException());
+    BOOST_CHECK_THROW(f.Get(), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(HasWorkConditionTest)
+{
+    TaskScheduler scheduler;
+    ISchedulerContext& context = scheduler.GetContext();
+
+    NullThrottler throttler;
+    BOOST_CHECK(context.Run(throttler) == ISchedulerContext::State::Idle);
+
+    volatile bool notified = false;
+    auto waiter = Waiter::Create([&] { notified = true; }, false);
+    BOOST_CHECK(context.GetHasWorkCondition().AddWaiter(waiter));
+
+    Future<void> f = scheduler.Post([] {});
+    BOOST_CHECK(notified);
+
+    context.Run(throttler);
+    BOOST_CHECK(f.IsReady());
+    waiter->Destroy();
+}
+
+BOOST_AUTO_TEST_CASE(ContextReuseTest)
+{
+    // More threads over time than the scheduler has room for contexts
+    TaskScheduler scheduler(2);
+    ISchedulerContext* first = nullptr;
+    for (int i = 0; i < 10; ++i)
+    {
+        ISchedulerContext* context = nullptr;
+        Thread thread([&]
+        {
+            context = &scheduler.GetContext();
+            scheduler.ReleaseContext(*context);
+        });
+        thread.Join();
+
+        if (first == nullptr)
+            first = context;
+
+        BOOST_CHECK_EQUAL(context, first);
+    }
+
+    // Nested use on one thread holds on to the same context
+    ISchedulerContext& context = scheduler.GetContext();
+    BOOST_CHECK_EQUAL(&scheduler.GetContext(), &context);
+    scheduler.ReleaseContext(context);
+    BOOST_CHECK_EQUAL(&scheduler.GetContext(), &context);
+    scheduler.ReleaseContext(context);
+    scheduler.ReleaseContext(context);
+}
+
+BOOST_AUTO_TEST_CASE(MetaSchedulerStealTest)
+{
+    std::shared_ptr<TaskScheduler> scheduler(new TaskScheduler());
+
+    MetaScheduler::Config config;
+    config.AddScheduler(scheduler, 0, RunMode::All());
+    MetaScheduler ms(config);
+
+    std::uint32_t const threadCount = 4;
+    for (std::uint32_t i = 0; i < threadCount; ++i)
+        ms.CreateMetaThread(MetaScheduler::MetaThreadConfig());
+
+    Event done;
+    std::vector<Thread> threads;
+    for (std::uint32_t i = 0; i < threadCount; ++i)
+    {
+        threads.push_back(Thread([&]
+        {
+            MetaScheduler::Context& context = ms.AcquireContext();
+            context.Run(done);
+            context.Release();
+        }));
+    }
+
+    // Each task fans out sub tasks onto the local deque for other contexts to steal
+    Atomic<std::uint32_t> count(0);
+    std::vector<Future<void>> results;
+    for (int i = 0; i < 100; ++i)
+    {
+        results.push_back(scheduler->Post([&]
+        {
+            for (int j = 0; j < 100; ++j)
+                scheduler->Post([&] { count.Increment(); });
+        }));
+    }
+
+    std::for_each(results.begin(), results.end(), [] (Future<void>& result)
+    {
+        result.Wait();
+    });
+
+    while (count.Load() != 10000)
+        ThreadYield();
+
+    done.Set();
+    std::for_each(threads.begin(), threads.end(), [] (Thread& t)
+    {
+        t.Join();
+    });
+
+    BOOST_CHECK_EQUAL(count.Load(), 10000u);
+}
+
+BOOST_AUTO_TEST_CASE(CooperativeWaitTest)
+{
+    std::shared_ptr<TaskScheduler> scheduler(new TaskScheduler());
+
+    MetaScheduler::Config config;
+    config.AddScheduler(scheduler, 0, RunMode::All());
+    MetaScheduler ms(config);
+    ms.CreateMetaThread(MetaScheduler::MetaThreadConfig());
+
+    Event done;
+    Thread thread([&]
+    {
+        MetaScheduler::Context& context = ms.AcquireContext();
+        context.Run(done);
+        context.Release();
+    });
+
+    // Only one thread runs tasks, so waiting on sub tasks only completes if the wait runs them
+    std::function<int (int)> sum = [&] (int depth) -> int
+    {
+        if (depth == 0)
+            return 1;
+
+        Future<int> left = scheduler->Post([&, depth] { return sum(depth - 1); });
+        Future<int> right = scheduler->Post([&, depth] { return sum(depth - 1); });
+        return left.Get() + right.Get();
+    };
+
+    Future<int> result = scheduler->Post([&] { return sum(6); });
+    BOOST_CHECK_EQUAL(result.Get(), 64);
+
+    // Blocking waits inside tasks still work when the awaited work runs elsewhere
+    Event external;
+    Future<bool> blocked = scheduler->Post([&] { return WaitFor(external, WaitMode::Block()); });
+    ThreadSleep(Duration::Milliseconds(10));
+    external.Set();
+    BOOST_CHECK(blocked.Get());
+
+    // An idle cooperative wait wakes up for work posted later, here the work it's waiting on
+    Event later;
+    Future<bool> woken = scheduler->Post([&] { return WaitFor(later); });
+    ThreadSleep(Duration::Milliseconds(10));
+    scheduler->Post([&] { later.Set(); });
+    BOOST_CHECK(woken.Get());
+
+    done.Set();
+    thread.Join();
+}
+
+BOOST_AUTO_TEST_CASE(CooperativeLockTest)
+{
+    std::shared_ptr<TaskScheduler> scheduler(new TaskScheduler());
+
+    MetaScheduler::Config config;
+    config.AddScheduler(scheduler, 0, RunMode::All());
+    MetaScheduler ms(config);
+    ms.CreateMetaThread(MetaScheduler::MetaThreadConfig());
+
+    Event done;
+    Thread thread([&]
+    {
+        MetaScheduler::Context& context = ms.AcquireContext();
+        context.Run(done);
+        context.Release();
+    });
+
+    // Lock waits block, so the first task doesn't run the second while it's being handed the mutex
+    Mutex mutex;
+    mutex.Lock();
+    Future<void> first = scheduler->Post([&] { mutex.Lock(); mutex.Unlock(); });
+    ThreadSleep(Duration::Milliseconds(10));
+    Future<void> second = scheduler->Post([&] { mutex.Lock(); mutex.Unlock(); });
+    ThreadSleep(Duration::Milliseconds(10));
+    mutex.Unlock();
+
+    first.Get();
+    second.Get();
+
+    done.Set();
+    thread.Join();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}}
@@ -2,9 +2,12 @@
 // Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
 
 #include "crunch/concurrency/thread_pool.hpp"
+#include "crunch/concurrency/yield.hpp"
 
 #include "crunch/test/framework.hpp"
 
+#include <stdexcept>
+
 namespace Crunch { namespace Concurrency {
 
 BOOST_AUTO_TEST_SUITE(ThreadPoolTests)
@@ -32,6 +35,91 @@ BOOST_AUTO_TEST_CASE(SpawnMaxTest)
     BOOST_CHECK_LE(tp.GetThreadCount(), 3u);
 }
 
+BOOST_AUTO_TEST_CASE(HighThroughputPostOneTest)
+{
+    ThreadPool tp(2, ThreadPool::MODE_HIGH_THROUGHPUT);
+    BOOST_CHECK_EQUAL(tp.GetThreadCount(), 2u);
+    Future<int> f = tp.Post([]{ return 123; });
+    BOOST_CHECK_EQUAL(f.Get(), 123);
+}
+
+BOOST_AUTO_TEST_CASE(HighThroughputNestedPostTest)
+{
+    ThreadPool tp(3, ThreadPool::MODE_HIGH_THROUGHPUT);
+    Atomic<std::uint32_t> count(0);
+    std::vector<Future<void>> results;
+
+    // Outer work posted externally, inner work posted from workers to their own queues
+    for (int i = 0; i < 100; ++i)
+    {
+        results.push_back(tp.Post([&]
+        {
+            for (int j = 0; j < 100; ++j)
+                tp.Post([&] { count.Increment(); });
+        }));
+    }
+
+    std::for_each(results.begin(), results.end(), [] (Future<void>& result)
+    {
+        result.Wait();
+    });
+
+    while (count.Load() != 10000)
+        ThreadYield();
+
+    BOOST_CHECK_EQUAL(count.Load(), 10000u);
+}
+
+BOOST_AUTO_TEST_CASE(ExceptionPropagatesTest)
+{
+    ThreadPool simple(1);
+    Future<int> f1 = simple.Post([]() -> int { throw std::runtime_error("simple"); });
+    BOOST_CHECK_THROW(f1.Get(), std::runtime_error);
+
+    ThreadPool highThroughput(1, ThreadPool::MODE_HIGH_THROUGHPUT);
+    Future<void> f2 = highThroughput.Post([] { throw std::runtime_error("high throughput"); });
+    BOOST_CHECK_THROW(f2.Get(), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(LargeCallableTest)
+{
+    // Too large for a pooled slot, so falls back to the heap
+    struct Large { char data[1024]; };
+    Large large;
+    large.data[0] = 1;
+    large.data[1023] = 2;
+
+    ThreadPool tp(1, ThreadPool::MODE_HIGH_THROUGHPUT);
+    Future<int> f = tp.Post([=] { return large.data[0] + large.data[1023]; });
+    BOOST_CHECK_EQUAL(f.Get(), 3);
+}
+
+BOOST_AUTO_TEST_CASE(ResultOutlivesPoolTest)
+{
+    std::vector<Future<int>> results;
+    {
+        ThreadPool tp(2, ThreadPool::MODE_HIGH_THROUGHPUT);
+        for (int i = 0; i < 10000; ++i)
+            results.push_back(tp.Post([=] { return i; }));
+    }
+
+    for (int i = 0; i < 10000; ++i)
+        BOOST_CHECK_EQUAL(results[i].Get(), i);
+}
+
+BOOST_AUTO_TEST_CASE(WorkPostedDuringDestructionTest)
+{
+    Atomic<std::uint32_t> count(0);
+    {
+        // Work left at destruction posts more work, which must run as well
+        ThreadPool tp(2, ThreadPool::MODE_HIGH_THROUGHPUT);
+        for (int i = 0; i < 10000; ++i)
+            tp.Post([&] { tp.Post([&] { count.Increment(); }); });
+    }
+
+    BOOST_CHECK_EQUAL(count.Load(), 10000u);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }}
@@ -0,0 +1,36 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#ifndef CRUNCH_CONCURRENCY_TEST_TRACKED_OBJECT_HPP
+#define CRUNCH_CONCURRENCY_TEST_TRACKED_OBJECT_HPP
+
+#include "crunch/concurrency/atomic.hpp"
+#include "crunch/concurrency/yield.hpp"
+
+#include <cstdint>
+
+namespace Crunch { namespace Concurrency {
+
+/// Retired object that counts its reclamation
+struct TrackedObject
+{
+    TrackedObject(Atomic<std::uint32_t>& reclaimed) : reclaimed(reclaimed) {}
+    ~TrackedObject() { reclaimed.Increment(); }
+
+    Atomic<std::uint32_t>& reclaimed;
+};
+
+/// Report quiescent states to Domain, e.g., Epoch or GracePeriod, until count objects have been reclaimed
+template<typename Domain>
+void QuiesceUntil(Atomic<std::uint32_t> const& reclaimed, std::uint32_t count)
+{
+    while (reclaimed.Load() != count)
+    {
+        Domain::Quiesce();
+        ThreadYield();
+    }
+}
+
+}}
+
+#endif
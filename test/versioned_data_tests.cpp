@@ -0,0 +1,100 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#include "crunch/concurrency/thread.hpp"
+#include "crunch/concurrency/versioned_data.hpp"
+#include "crunch/test/framework.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace Crunch { namespace Concurrency {
+
+BOOST_AUTO_TEST_SUITE(VersionedDataTests)
+
+namespace
+{
+    struct TestData
+    {
+        std::uint32_t values[16];
+    };
+
+    template<typename DataType>
+    void RunUpdateReadTest()
+    {
+        DataType data;
+        std::uint32_t version = 0;
+        std::uint32_t value = 0;
+        BOOST_CHECK(!data.HasChanged(version));
+
+        // Nothing read if unchanged
+        data.ReadIfDifferent(version, [&] (std::uint32_t x) { value = x; });
+        BOOST_CHECK_EQUAL(value, 0u);
+
+        data.Update([] (std::uint32_t& x) { x = 5; });
+        BOOST_CHECK(data.HasChanged(version));
+        data.ReadIfDifferent(version, [&] (std::uint32_t x) { value = x; });
+        BOOST_CHECK_EQUAL(value, 5u);
+        BOOST_CHECK_EQUAL(version, 1u);
+        BOOST_CHECK(!data.HasChanged(version));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(UpdateReadTest)
+{
+    RunUpdateReadTest<VersionedData<std::uint32_t>>();
+}
+
+BOOST_AUTO_TEST_CASE(SeqLockUpdateReadTest)
+{
+    RunUpdateReadTest<SeqLockVersionedData<std::uint32_t>>();
+}
+
+BOOST_AUTO_TEST_CASE(SeqLockConsistentReadTest)
+{
+    SeqLockVersionedData<TestData> data;
+    std::uint32_t const updateCount = 20000;
+    volatile bool done = false;
+
+    // Every update writes the same value to all fields, so a torn read shows up as differing fields
+    std::vector<Thread> readers;
+    for (int r = 0; r < 3; ++r)
+    {
+        readers.push_back(Thread([&]
+        {
+            std::uint32_t version = 0;
+            std::uint32_t lastValue = 0;
+            while (!done)
+            {
+                data.ReadIfDifferent(version, [&] (TestData const& read)
+                {
+                    for (int i = 1; i < 16; ++i)
+                        BOOST_REQUIRE_EQUAL(read.values[i], read.values[0]);
+
+                    BOOST_REQUIRE_GE(read.values[0], lastValue);
+                    lastValue = read.values[0];
+                });
+            }
+        }));
+    }
+
+    for (std::uint32_t u = 1; u <= updateCount; ++u)
+    {
+        data.Update([u] (TestData& d)
+        {
+            for (int i = 0; i < 16; ++i)
+                d.values[i] = u;
+        });
+    }
+
+    done = true;
+    std::for_each(readers.begin(), readers.end(), [] (Thread& t) { t.Join(); });
+
+    std::uint32_t version = 0;
+    data.ReadIfDifferent(version, [&] (TestData const& read) { BOOST_CHECK_EQUAL(read.values[15], updateCount); });
+    BOOST_CHECK_EQUAL(version, updateCount);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}}
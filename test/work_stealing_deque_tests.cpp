@@ -0,0 +1,64 @@
+// Copyright (c) 2013, Christian Rorvik
+// Distributed under the Simplified BSD License (See accompanying file LICENSE.txt)
+
+#include "crunch/concurrency/work_stealing_deque.hpp"
+#include "crunch/test/framework.hpp"
+
+namespace Crunch { namespace Concurrency {
+
+BOOST_AUTO_TEST_SUITE(WorkStealingDequeTests)
+
+BOOST_AUTO_TEST_CASE(InitialStateTest)
+{
+    WorkStealingDeque<int> deque;
+    BOOST_CHECK(deque.IsEmpty());
+    BOOST_CHECK_EQUAL(deque.Pop(), (int*)0);
+    BOOST_CHECK_EQUAL(deque.Steal(), (int*)0);
+}
+
+BOOST_AUTO_TEST_CASE(PopIsLifoTest)
+{
+    WorkStealingDeque<int> deque;
+
+    int n[5];
+    for (int i = 0; i < 5; ++i)
+        deque.Push(n + i);
+
+    for (int i = 4; i >= 0; --i)
+        BOOST_CHECK_EQUAL(deque.Pop(), n + i);
+
+    BOOST_CHECK_EQUAL(deque.Pop(), (int*)0);
+}
+
+BOOST_AUTO_TEST_CASE(StealIsFifoTest)
+{
+    WorkStealingDeque<int> deque;
+
+    int n[5];
+    for (int i = 0; i < 5; ++i)
+        deque.Push(n + i);
+
+    for (int i = 0; i < 5; ++i)
+        BOOST_CHECK_EQUAL(deque.Steal(), n + i);
+
+    BOOST_CHECK_EQUAL(deque.Steal(), (int*)0);
+}
+
+BOOST_AUTO_TEST_CASE(GrowTest)
+{
+    WorkStealingDeque<int> deque(1);
+
+    int n[100];
+    for (int i = 0; i < 100; ++i)
+        deque.Push(n + i);
+
+    BOOST_CHECK_EQUAL(deque.Steal(), n + 0);
+    for (int i = 99; i >= 1; --i)
+        BOOST_CHECK_EQUAL(deque.Pop(), n + i);
+
+    BOOST_CHECK(deque.IsEmpty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}}